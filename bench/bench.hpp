@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+// Include order matters.
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+class Stopwatch {
+public:
+    Stopwatch() : start_(Clock::now()) {}
+
+    void reset() { start_ = Clock::now(); }
+
+    double elapsedNs() const { return std::chrono::duration<double, std::nano>(Clock::now() - start_).count(); }
+    double elapsedMs() const { return elapsedNs() / 1e6; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start_;
+};
+
+struct Stats {
+    std::size_t count = 0;
+    double mean = 0;
+    double min = 0;
+    double p50 = 0;
+    double p90 = 0;
+    double p99 = 0;
+    double max = 0;
+};
+
+// Sorts the samples in place.
+inline Stats stats(std::vector<double>& samples) {
+    Stats result;
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double p) {
+        return samples[std::min(samples.size() - 1, static_cast<std::size_t>(p * samples.size()))];
+    };
+    result.count = samples.size();
+    result.mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    result.min = samples.front();
+    result.p50 = percentile(0.5);
+    result.p90 = percentile(0.9);
+    result.p99 = percentile(0.99);
+    result.max = samples.back();
+    return result;
+}
+
+inline std::string format(const Stats& s, const char* unit) {
+    char buffer[256];
+    std::snprintf(buffer,
+                  sizeof(buffer),
+                  "n=%zu mean=%.2f%s p50=%.2f%s p90=%.2f%s p99=%.2f%s max=%.2f%s",
+                  s.count,
+                  s.mean,
+                  unit,
+                  s.p50,
+                  unit,
+                  s.p90,
+                  unit,
+                  s.p99,
+                  unit,
+                  s.max,
+                  unit);
+    return buffer;
+}
+
+// Peak resident set size of the process in megabytes. The value never decreases, so
+// use runIsolated() to measure more than one dataset per run.
+inline double peakMemoryMb() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    struct rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+    return usage.ru_maxrss / 1024.0;
+#endif
+#endif
+}
+
+// Runs `function(isolated)` in a child process and waits for it, so that peakMemoryMb()
+// called inside covers that call only. Where processes cannot be forked, the function
+// runs in this process with `isolated` set to false.
+//
+// Returns false, after printing why, if the child did not exit normally with status 0.
+template <typename TFunction>
+inline bool runIsolated(const TFunction& function) {
+#if defined(_WIN32)
+    function(false);
+    return true;
+#else
+    std::cout.flush();
+    std::fflush(stdout);
+    const pid_t pid = fork();
+    if (pid < 0) {
+        function(false);
+        return true;
+    }
+    if (pid == 0) {
+        function(true);
+        std::cout.flush();
+        std::fflush(stdout);
+        std::_Exit(0);
+    }
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            std::cerr << "Could not wait for the benchmark process" << std::endl;
+            return false;
+        }
+    }
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        return true;
+    }
+    if (WIFSIGNALED(status)) {
+        std::cerr << "Benchmark process was killed by signal " << WTERMSIG(status) << std::endl;
+    } else {
+        std::cerr << "Benchmark process failed with status " << WEXITSTATUS(status) << std::endl;
+    }
+    return false;
+#endif
+}
+
+// Splits a comma separated list.
+inline std::vector<std::string> split(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    for (std::string item; std::getline(stream, item, ',');) {
+        items.push_back(item);
+    }
+    return items;
+}
+
+// Keeps the optimizer from dropping computations whose result is otherwise unused.
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+} // namespace bench
@@ -0,0 +1,236 @@
+#include "bench.hpp"
+
+#include <args.hxx>
+#include <mapbox/batch_ruler.hpp>
+#include <mapbox/cheap_ruler.hpp>
+#include <mapbox/geodesic_ruler.hpp>
+#include <mapbox/prepared_line.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using mapbox::cheap_ruler::CheapRuler;
+using mapbox::cheap_ruler::line_string;
+using mapbox::cheap_ruler::point;
+
+struct Config {
+    double latitude;
+    std::size_t ops;
+    std::size_t repeats;
+    std::size_t linePoints;
+};
+
+// A random walk of roughly 10 m steps, like a GPS trace.
+line_string makeTrace(double latitude, std::size_t count, std::mt19937& rng) {
+    std::normal_distribution<double> step(0.0, 0.0001);
+    line_string line;
+    line.reserve(count);
+    point p(0.0, latitude);
+    for (std::size_t i = 0; i < count; ++i) {
+        p.x += step(rng);
+        p.y += step(rng);
+        line.push_back(p);
+    }
+    return line;
+}
+
+std::vector<point> makePoints(const line_string& near, std::size_t count, std::mt19937& rng) {
+    std::uniform_int_distribution<std::size_t> pick(0, near.size() - 1);
+    std::normal_distribution<double> offset(0.0, 0.001);
+    std::vector<point> points;
+    points.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const point& p = near[pick(rng)];
+        points.emplace_back(p.x + offset(rng), p.y + offset(rng));
+    }
+    return points;
+}
+
+// Runs `op(i)` for i in [0, ops) `repeats` times and prints the time per item, where each
+// call handles `itemsPerOp` items.
+template <typename TOp>
+void measure(const char* name, const Config& config, std::size_t ops, TOp&& op, std::size_t itemsPerOp = 1) {
+    std::vector<double> samples;
+    for (std::size_t repeat = 0; repeat < config.repeats; ++repeat) {
+        bench::Stopwatch stopwatch;
+        for (std::size_t i = 0; i < ops; ++i) {
+            op(i);
+        }
+        samples.push_back(stopwatch.elapsedNs() / static_cast<double>(ops * itemsPerOp));
+    }
+    std::printf("%-28s %s\n", name, bench::format(bench::stats(samples), "ns").c_str());
+}
+
+void runSpeed(const Config& config, std::mt19937& rng) {
+    std::cout << "== ns/op at latitude " << config.latitude << ", " << config.linePoints << " point lines"
+              << std::endl;
+
+    CheapRuler ruler(config.latitude);
+    const line_string trace = makeTrace(config.latitude, config.linePoints, rng);
+    const std::vector<point> points = makePoints(trace, config.ops, rng);
+    mapbox::cheap_ruler::polygon polygon;
+    polygon.emplace_back(trace.begin(), trace.end());
+    const mapbox::cheap_ruler::box box(trace[0], trace[trace.size() / 2]);
+    const std::size_t lineOps = std::max<std::size_t>(1, config.ops / config.linePoints);
+    const std::size_t n = points.size();
+
+    measure("distance", config, n, [&](std::size_t i) {
+        bench::doNotOptimize(ruler.distance(points[i], points[(i + 1) % n]));
+    });
+    measure("bearing", config, n, [&](std::size_t i) {
+        bench::doNotOptimize(ruler.bearing(points[i], points[(i + 1) % n]));
+    });
+    measure("destination", config, n, [&](std::size_t i) {
+        bench::doNotOptimize(ruler.destination(points[i], 1.0, static_cast<double>(i % 360)));
+    });
+    measure("bufferBBox", config, n, [&](std::size_t i) {
+        bench::doNotOptimize(ruler.bufferBBox(box, static_cast<double>(i % 10)));
+    });
+    measure("lineDistance", config, lineOps, [&](std::size_t) { bench::doNotOptimize(ruler.lineDistance(trace)); });
+    measure("area", config, lineOps, [&](std::size_t) { bench::doNotOptimize(ruler.area(polygon)); });
+    measure("pointOnLine", config, lineOps, [&](std::size_t i) {
+        bench::doNotOptimize(ruler.pointOnLine(trace, points[i % n]));
+    });
+
+    // The same measurements through the helpers of Mapbox::Base::ruler.
+    const mapbox::base::BatchRuler batch(ruler);
+    std::vector<double> xs;
+    std::vector<double> ys;
+    for (const auto& p : points) {
+        xs.push_back(p.x);
+        ys.push_back(p.y);
+    }
+    std::vector<double> out(n);
+    std::vector<double> traceXs;
+    std::vector<double> traceYs;
+    for (const auto& p : trace) {
+        traceXs.push_back(p.x);
+        traceYs.push_back(p.y);
+    }
+    measure(
+        "BatchRuler::distances",
+        config,
+        1,
+        [&](std::size_t) {
+            batch.distances(points[0], xs.data(), ys.data(), n, out.data());
+            bench::doNotOptimize(out.data());
+        },
+        n);
+    measure(
+        "BatchRuler::lineDistance",
+        config,
+        lineOps,
+        [&](std::size_t) { bench::doNotOptimize(batch.lineDistance(traceXs.data(), traceYs.data(), traceXs.size())); });
+
+    const mapbox::base::PreparedLine prepared(trace, ruler);
+    measure("PreparedLine::pointOnLine", config, n, [&](std::size_t i) {
+        bench::doNotOptimize(prepared.pointOnLine(points[i]));
+    });
+
+    const mapbox::base::GeodesicRuler geodesic;
+    measure("GeodesicRuler::distance", config, n, [&](std::size_t i) {
+        bench::doNotOptimize(geodesic.distance(points[i], points[(i + 1) % n]));
+    });
+    const mapbox::base::AutoRuler autoRuler;
+    measure("AutoRuler::distance", config, n, [&](std::size_t i) {
+        bench::doNotOptimize(autoRuler.distance(points[i], points[(i + 1) % n]));
+    });
+}
+
+// Relative error of CheapRuler::distance against the ellipsoidal distance, for pairs of
+// points whose first point lies in each latitude band. The ruler is made for the
+// latitude of the first point, which is how it is normally used.
+void runAccuracy(double bandWidth,
+                 const std::vector<double>& distances,
+                 std::size_t samples,
+                 std::mt19937& rng) {
+    std::cout << "== relative error of CheapRuler::distance vs. GeodesicRuler, max (mean) in %" << std::endl;
+    std::printf("%-12s", "latitude");
+    for (const double distance : distances) {
+        std::printf(" %16.0f km", distance);
+    }
+    std::printf("\n");
+
+    const mapbox::base::GeodesicRuler geodesic;
+    std::uniform_real_distribution<double> bearing(-180.0, 180.0);
+    for (double band = -90.0; band < 90.0; band += bandWidth) {
+        const double top = std::min(90.0, band + bandWidth);
+        std::uniform_real_distribution<double> latitude(band, top);
+        std::printf("%5.0f..%-5.0f", band, top);
+        for (const double distance : distances) {
+            double maxError = 0;
+            double sumError = 0;
+            for (std::size_t i = 0; i < samples; ++i) {
+                const point from(0.0, latitude(rng));
+                const point to = geodesic.destination(from, distance, bearing(rng));
+                CheapRuler ruler(from.y);
+                const double error = std::abs(ruler.distance(from, to) - distance) / distance;
+                maxError = std::max(maxError, error);
+                sumError += error;
+            }
+            std::printf(" %9.4f (%7.4f)", maxError * 100.0, sumError / samples * 100.0);
+        }
+        std::printf("\n");
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    args::ArgumentParser parser("CheapRuler benchmark",
+                                "Measures the cost of CheapRuler operations and its error against an ellipsoidal "
+                                "reference over latitude bands.");
+    args::HelpFlag help(parser, "help", "Show this help", {'h', "help"});
+    args::ValueFlag<double> latitude(parser, "degrees", "Latitude of the speed test", {"latitude"}, 45.0);
+    args::ValueFlag<std::size_t> ops(parser, "count", "Calls per repeat of each operation", {'n', "ops"}, 1000000);
+    args::ValueFlag<std::size_t> repeats(parser, "count", "Repeats of each operation", {"repeats"}, 10);
+    args::ValueFlag<std::size_t> linePoints(parser, "count", "Points per line", {"line-points"}, 1000);
+    args::ValueFlag<double> bandWidth(parser, "degrees", "Width of the latitude bands", {"band"}, 10.0);
+    args::ValueFlag<std::string> distances(
+        parser, "list", "Comma separated distances of the accuracy test in km", {"distances"}, "1,10,100,500,1000");
+    args::ValueFlag<std::size_t> samples(parser, "count", "Pairs per band and distance", {"samples"}, 1000);
+    args::ValueFlag<unsigned> seed(parser, "seed", "Random seed", {"seed"}, 42);
+    args::Flag skipSpeed(parser, "accuracy-only", "Only run the accuracy test", {"accuracy-only"});
+    args::Flag skipAccuracy(parser, "speed-only", "Only run the speed test", {"speed-only"});
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (const args::Help&) {
+        std::cout << parser;
+        return 0;
+    } catch (const args::Error& e) {
+        std::cerr << e.what() << std::endl << parser;
+        return 1;
+    }
+
+    Config config;
+    config.latitude = args::get(latitude);
+    config.ops = std::max<std::size_t>(1, args::get(ops));
+    config.repeats = std::max<std::size_t>(1, args::get(repeats));
+    config.linePoints = std::max<std::size_t>(2, args::get(linePoints));
+
+    std::vector<double> accuracyDistances;
+    std::istringstream list(args::get(distances));
+    for (std::string item; std::getline(list, item, ',');) {
+        accuracyDistances.push_back(std::stod(item));
+    }
+
+    std::mt19937 rng(args::get(seed));
+    if (!skipSpeed) {
+        runSpeed(config, rng);
+    }
+    if (!skipAccuracy) {
+        runAccuracy(
+            std::max(1.0, args::get(bandWidth)), accuracyDistances, std::max<std::size_t>(1, args::get(samples)), rng);
+    }
+
+    return 0;
+}
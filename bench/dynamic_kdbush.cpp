@@ -0,0 +1,74 @@
+#include "bench.hpp"
+
+#include <args.hxx>
+#include <mapbox/dynamic_kdbush.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Times each call of `op(i)` for i in [0, count) and prints the distribution, so that the
+// worst single call shows next to the mean.
+template <typename TOp>
+void measure(const char* name, std::size_t count, TOp&& op) {
+    std::vector<double> samples;
+    samples.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        bench::Stopwatch stopwatch;
+        op(i);
+        samples.push_back(stopwatch.elapsedNs() / 1e3);
+    }
+    std::printf("%-10s %s\n", name, bench::format(bench::stats(samples), "us").c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    args::ArgumentParser parser("DynamicKDBush benchmark",
+                                "Measures the time of every single insert, move and remove of a DynamicKDBush, "
+                                "including the worst one.");
+    args::HelpFlag help(parser, "help", "Show this help", {'h', "help"});
+    args::ValueFlag<std::size_t> points(parser, "count", "Points inserted first", {'n', "points"}, 1000000);
+    args::ValueFlag<std::size_t> updates(parser, "count", "Moves and removes after that", {"updates"}, 1000000);
+    args::ValueFlag<std::size_t> bufferSize(parser, "count", "Buffer size of the index", {"buffer"}, 128);
+    args::ValueFlag<unsigned> seed(parser, "seed", "Random seed", {"seed"}, 42);
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (const args::Help&) {
+        std::cout << parser;
+        return 0;
+    } catch (const args::Error& e) {
+        std::cerr << e.what() << std::endl << parser;
+        return 1;
+    }
+
+    const std::size_t n = std::max<std::size_t>(1, args::get(points));
+    std::mt19937 rng(args::get(seed));
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    std::uniform_int_distribution<std::uint32_t> pickId(0, static_cast<std::uint32_t>(n - 1));
+
+    mapbox::base::DynamicKDBush<double> index(std::max<std::size_t>(1, args::get(bufferSize)));
+    std::cout << "== " << n << " points, buffer " << std::max<std::size_t>(1, args::get(bufferSize)) << std::endl;
+
+    measure("insert", n, [&](std::size_t i) {
+        index.insert(static_cast<std::uint32_t>(i), coordinate(rng), coordinate(rng));
+    });
+    // Every fourth update removes a point and the others move one, which inserts it again
+    // if it was removed.
+    measure("update", args::get(updates), [&](std::size_t i) {
+        if (i % 4 == 3) {
+            index.remove(pickId(rng));
+        } else {
+            index.insert(pickId(rng), coordinate(rng), coordinate(rng));
+        }
+    });
+    measure("compact", 1, [&](std::size_t) { index.compact(); });
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include "bench.hpp"
+
+#include <args.hxx>
+#include <mapbox/image_diff.hpp>
+#include <mapbox/pixelmatch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Image = std::vector<std::uint8_t>;
+
+struct Pair {
+    Image img1;
+    Image img2;
+};
+
+// Soft-edged discs on a gradient, shifted horizontally by `shift` pixels. Shifting by a
+// fraction of a pixel changes only the anti-aliased edges.
+Image render(std::size_t size, double shift) {
+    Image image(size * size * 4);
+    const double radius = size / 20.0;
+    for (std::size_t y = 0; y < size; ++y) {
+        for (std::size_t x = 0; x < size; ++x) {
+            const double cx = std::fmod(x + 0.5 - shift, size / 8.0) - size / 16.0;
+            const double cy = std::fmod(y + 0.5, size / 8.0) - size / 16.0;
+            const double coverage = std::min(1.0, std::max(0.0, radius - std::hypot(cx, cy) + 0.5));
+            std::uint8_t* p = &image[(y * size + x) * 4];
+            p[0] = static_cast<std::uint8_t>(240.0 - 200.0 * coverage);
+            p[1] = static_cast<std::uint8_t>((x * 200) / size * (1.0 - coverage) + 30.0 * coverage);
+            p[2] = static_cast<std::uint8_t>((y * 200) / size * (1.0 - coverage) + 180.0 * coverage);
+            p[3] = 255;
+        }
+    }
+    return image;
+}
+
+Pair makePair(const std::string& kind, std::size_t size, std::mt19937& rng) {
+    Pair pair;
+    pair.img1 = render(size, 0.0);
+    if (kind == "identical") {
+        pair.img2 = pair.img1;
+    } else if (kind == "noise") {
+        // About one pixel in ten thousand differs.
+        pair.img2 = pair.img1;
+        std::uniform_int_distribution<std::size_t> pixel(0, size * size - 1);
+        for (std::size_t i = 0; i < size * size / 10000 + 1; ++i) {
+            std::uint8_t* p = &pair.img2[pixel(rng) * 4];
+            p[0] = static_cast<std::uint8_t>(255 - p[0]);
+            p[1] = static_cast<std::uint8_t>(255 - p[1]);
+        }
+    } else if (kind == "aa") {
+        pair.img2 = render(size, 0.3);
+    } else {
+        pair.img2 = pair.img1;
+        for (auto& value : pair.img2) {
+            value = static_cast<std::uint8_t>(255 - value);
+        }
+        for (std::size_t i = 3; i < pair.img2.size(); i += 4) {
+            pair.img2[i] = 255;
+        }
+    }
+    return pair;
+}
+
+// Runs `op` `repeats` times and prints the throughput in megapixels per second, followed
+// by the value op returned.
+template <typename TOp>
+void measure(const std::string& name, std::size_t pixels, std::size_t repeats, TOp&& op) {
+    std::vector<double> samples;
+    std::uint64_t result = 0;
+    for (std::size_t i = 0; i < repeats; ++i) {
+        bench::Stopwatch stopwatch;
+        result = op();
+        samples.push_back(pixels / (stopwatch.elapsedNs() / 1e3));
+    }
+    std::printf("  %-30s %s, result %llu\n",
+                name.c_str(),
+                bench::format(bench::stats(samples), "MP/s").c_str(),
+                static_cast<unsigned long long>(result));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    args::ArgumentParser parser("pixelmatch benchmark",
+                                "Compares synthetic image pairs with mapbox::pixelmatch and mapbox::base::imageDiff.");
+    args::HelpFlag help(parser, "help", "Show this help", {'h', "help"});
+    args::ValueFlag<std::string> sizes(
+        parser, "list", "Comma separated image sizes in pixels", {'s', "sizes"}, "256,1024,2048");
+    args::ValueFlag<std::string> pairs(parser,
+                                       "list",
+                                       "Comma separated image pairs: identical, noise, aa, different",
+                                       {'p', "pairs"},
+                                       "identical,noise,aa,different");
+    args::ValueFlag<std::size_t> repeats(parser, "count", "Repeats of each comparison", {"repeats"}, 5);
+    args::ValueFlag<unsigned> threads(
+        parser, "count", "imageDiff threads, 0 for one per hardware thread", {"threads"}, 0);
+    args::ValueFlag<unsigned> seed(parser, "seed", "Random seed", {"seed"}, 42);
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (const args::Help&) {
+        std::cout << parser;
+        return 0;
+    } catch (const args::Error& e) {
+        std::cerr << e.what() << std::endl << parser;
+        return 1;
+    }
+
+    std::mt19937 rng(args::get(seed));
+    const std::size_t runs = std::max<std::size_t>(1, args::get(repeats));
+    for (const auto& sizeItem : bench::split(args::get(sizes))) {
+        const std::size_t size = std::stoul(sizeItem);
+        const std::size_t pixels = size * size;
+        Image output(pixels * 4);
+
+        for (const auto& kind : bench::split(args::get(pairs))) {
+            const Pair pair = makePair(kind, size, rng);
+            std::cout << "== " << kind << ", " << size << "x" << size << std::endl;
+
+            for (const bool includeAA : {false, true}) {
+                const std::string aa = includeAA ? " includeAA" : "";
+                measure("pixelmatch" + aa, pixels, runs, [&] {
+                    return mapbox::pixelmatch(pair.img1.data(), pair.img2.data(), size, size, nullptr, 0.1, includeAA);
+                });
+                measure("pixelmatch output" + aa, pixels, runs, [&] {
+                    return mapbox::pixelmatch(
+                        pair.img1.data(), pair.img2.data(), size, size, output.data(), 0.1, includeAA);
+                });
+
+                mapbox::base::ImageDiffOptions options;
+                options.includeAA = includeAA;
+                options.threads = 1;
+                measure("imageDiff 1 thread" + aa, pixels, runs, [&] {
+                    return mapbox::base::imageDiff(pair.img1.data(), pair.img2.data(), size, size, nullptr, options);
+                });
+                options.threads = args::get(threads);
+                measure("imageDiff" + aa, pixels, runs, [&] {
+                    return mapbox::base::imageDiff(pair.img1.data(), pair.img2.data(), size, size, nullptr, options);
+                });
+                measure("imageDiff output" + aa, pixels, runs, [&] {
+                    return mapbox::base::imageDiff(
+                        pair.img1.data(), pair.img2.data(), size, size, output.data(), options);
+                });
+                mapbox::base::ImageDiffSummary summary;
+                measure("imageDiff summary" + aa, pixels, runs, [&] {
+                    return mapbox::base::imageDiff(
+                        pair.img1.data(), pair.img2.data(), size, size, nullptr, &summary, options);
+                });
+                measure("imagesMatch(100)" + aa, pixels, runs, [&] {
+                    return std::uint64_t(
+                        mapbox::base::imagesMatch(pair.img1.data(), pair.img2.data(), size, size, 100, options));
+                });
+            }
+        }
+    }
+
+    return 0;
+}
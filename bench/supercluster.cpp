@@ -0,0 +1,329 @@
+#include "bench.hpp"
+
+#include <args.hxx>
+#include <mapbox/geojson.hpp>
+#include <mapbox/geojson_impl.hpp>
+#include <mapbox/io.hpp>
+#include <supercluster.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using mapbox::feature::feature_collection;
+using mapbox::geometry::point;
+using mapbox::supercluster::Options;
+using mapbox::supercluster::Supercluster;
+
+constexpr double kMaxLatitude = 85.0;
+
+feature_collection<double> makeUniform(std::size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<double> lng(-180.0, 180.0);
+    std::uniform_real_distribution<double> lat(-kMaxLatitude, kMaxLatitude);
+
+    feature_collection<double> features;
+    features.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        features.emplace_back(point<double>(lng(rng), lat(rng)));
+    }
+    return features;
+}
+
+// Points normally distributed around a fixed number of randomly placed centres, which
+// resembles city-level density better than a uniform spread.
+feature_collection<double> makeHotspots(std::size_t count, std::size_t hotspots, double sigma, std::mt19937& rng) {
+    std::uniform_real_distribution<double> lng(-180.0, 180.0);
+    std::uniform_real_distribution<double> lat(-60.0, 60.0);
+    std::vector<point<double>> centres;
+    for (std::size_t i = 0; i < hotspots; ++i) {
+        centres.emplace_back(lng(rng), lat(rng));
+    }
+
+    std::uniform_int_distribution<std::size_t> pick(0, hotspots - 1);
+    std::normal_distribution<double> offset(0.0, sigma);
+
+    feature_collection<double> features;
+    features.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& centre = centres[pick(rng)];
+        const double x = std::remainder(centre.x + offset(rng), 360.0);
+        const double y = std::max(-kMaxLatitude, std::min(kMaxLatitude, centre.y + offset(rng)));
+        features.emplace_back(point<double>(x, y));
+    }
+    return features;
+}
+
+// Resamples the points of a GeoJSON file to the requested size. Points are cycled with a
+// small jitter, so the result keeps the density pattern of the source data.
+feature_collection<double> makeFromSource(const std::vector<point<double>>& source,
+                                          std::size_t count,
+                                          std::mt19937& rng) {
+    std::uniform_real_distribution<double> jitter(-0.01, 0.01);
+
+    feature_collection<double> features;
+    features.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto& p = source[i % source.size()];
+        if (i < source.size()) {
+            features.emplace_back(p);
+        } else {
+            features.emplace_back(point<double>(p.x + jitter(rng), p.y + jitter(rng)));
+        }
+    }
+    return features;
+}
+
+bool loadPoints(const std::string& path, std::vector<point<double>>& points) {
+    auto data = mapbox::base::io::readFile(path);
+    if (!data) {
+        std::cerr << data.error() << std::endl;
+        return false;
+    }
+
+    const auto geojson = mapbox::geojson::parse(*data);
+    if (!geojson.is<mapbox::geojson::feature_collection>()) {
+        std::cerr << "'" << path << "' is not a GeoJSON feature collection" << std::endl;
+        return false;
+    }
+    for (const auto& feature : geojson.get<mapbox::geojson::feature_collection>()) {
+        if (feature.geometry.is<point<double>>()) {
+            points.push_back(feature.geometry.get<point<double>>());
+        }
+    }
+    if (points.empty()) {
+        std::cerr << "'" << path << "' has no point features" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+struct TileId {
+    std::uint8_t z;
+    std::uint32_t x;
+    std::uint32_t y;
+};
+
+TileId tileOf(const point<double>& p, std::uint8_t z) {
+    const double z2 = std::pow(2.0, z);
+    const double sine = std::sin(p.y * M_PI / 180.0);
+    const double x = (p.x / 360.0 + 0.5) * z2;
+    const double y = (0.5 - 0.25 * std::log((1.0 + sine) / (1.0 - sine)) / M_PI) * z2;
+    auto clamp = [z2](double v) {
+        return static_cast<std::uint32_t>(std::max(0.0, std::min(z2 - 1.0, std::floor(v))));
+    };
+    return {z, clamp(x), clamp(y)};
+}
+
+bool clusterId(const mapbox::feature::property_map& properties, std::uint32_t& id) {
+    auto it = properties.find("cluster_id");
+    if (it == properties.end()) {
+        return false;
+    }
+    if (it->second.is<std::uint64_t>()) {
+        id = static_cast<std::uint32_t>(it->second.get<std::uint64_t>());
+        return true;
+    }
+    if (it->second.is<std::int64_t>()) {
+        id = static_cast<std::uint32_t>(it->second.get<std::int64_t>());
+        return true;
+    }
+    return false;
+}
+
+struct Config {
+    Options options;
+    std::size_t tileSamples;
+    std::size_t leafSamples;
+    bool perZoom;
+};
+
+// `isolated` tells whether this run has a process of its own, in which case the peak
+// memory covers this dataset only.
+void run(const std::string& name,
+         const feature_collection<double>& features,
+         const Config& config,
+         bool isolated,
+         std::mt19937& rng) {
+    std::cout << "== " << name << ", " << features.size() << " points" << std::endl;
+
+    if (config.perZoom) {
+        // Supercluster builds every zoom in its constructor, so the cost of a zoom is
+        // approximated by the difference between builds that stop one zoom apart.
+        double previous = 0;
+        for (int maxZoom = config.options.minZoom; maxZoom <= config.options.maxZoom; ++maxZoom) {
+            Options options = config.options;
+            options.maxZoom = static_cast<std::uint8_t>(maxZoom);
+            bench::Stopwatch stopwatch;
+            Supercluster index(features, options);
+            const double elapsed = stopwatch.elapsedMs();
+            bench::doNotOptimize(index);
+            std::printf("build z%-2d %10.2f ms (+%.2f ms)\n", maxZoom, elapsed, elapsed - previous);
+            previous = elapsed;
+        }
+    }
+
+    bench::Stopwatch stopwatch;
+    Supercluster index(features, config.options);
+    std::printf("build     %10.2f ms, peak memory %.1f MB%s\n",
+                stopwatch.elapsedMs(),
+                bench::peakMemoryMb(),
+                isolated ? "" : " (high-water mark of all runs so far)");
+
+    std::uniform_int_distribution<std::size_t> pick(0, features.size() - 1);
+    std::vector<double> samples;
+    std::vector<std::uint32_t> clusters;
+
+    for (int z = config.options.minZoom; z <= config.options.maxZoom + 1; ++z) {
+        samples.clear();
+        clusters.clear();
+        std::size_t tileFeatures = 0;
+
+        for (std::size_t i = 0; i < config.tileSamples; ++i) {
+            const auto& p = features[pick(rng)].geometry.get<point<double>>();
+            const TileId tile = tileOf(p, static_cast<std::uint8_t>(z));
+
+            stopwatch.reset();
+            const auto result = index.getTile(tile.z, tile.x, tile.y);
+            samples.push_back(stopwatch.elapsedNs() / 1e3);
+
+            tileFeatures += result.size();
+            for (const auto& feature : result) {
+                std::uint32_t id;
+                if (clusters.size() < config.leafSamples && clusterId(feature.properties, id)) {
+                    clusters.push_back(id);
+                }
+            }
+        }
+        std::printf("getTile z%-2d %s, %.1f features/tile\n",
+                    z,
+                    bench::format(bench::stats(samples), "us").c_str(),
+                    static_cast<double>(tileFeatures) / config.tileSamples);
+
+        if (clusters.empty()) {
+            continue;
+        }
+
+        samples.clear();
+        for (const auto id : clusters) {
+            stopwatch.reset();
+            const auto leaves = index.getLeaves(id, 10, 0);
+            samples.push_back(stopwatch.elapsedNs() / 1e3);
+            bench::doNotOptimize(leaves);
+        }
+        std::printf("  getLeaves(10)  %s\n", bench::format(bench::stats(samples), "us").c_str());
+
+        samples.clear();
+        std::size_t leafCount = 0;
+        for (const auto id : clusters) {
+            stopwatch.reset();
+            const auto leaves = index.getLeaves(id, std::numeric_limits<std::uint32_t>::max(), 0);
+            samples.push_back(stopwatch.elapsedNs() / 1e3);
+            leafCount += leaves.size();
+        }
+        std::printf("  getLeaves(all) %s, %.1f leaves/cluster\n",
+                    bench::format(bench::stats(samples), "us").c_str(),
+                    static_cast<double>(leafCount) / clusters.size());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    args::ArgumentParser parser("Supercluster benchmark",
+                                "Clusters synthetic and GeoJSON point datasets and measures build and query cost.");
+    args::HelpFlag help(parser, "help", "Show this help", {'h', "help"});
+    args::ValueFlagList<std::size_t> sizes(parser, "count", "Dataset size, repeatable", {'n', "points"});
+    args::ValueFlag<std::string> datasets(
+        parser, "list", "Comma separated synthetic datasets: uniform, hotspots", {'d', "dataset"}, "uniform,hotspots");
+    args::ValueFlag<std::string> geojson(
+        parser, "file", "Also run a GeoJSON point dataset, e.g. places.json from supercluster.hpp", {"geojson"});
+    args::ValueFlag<int> radius(parser, "px", "Cluster radius", {"radius"}, 40);
+    args::ValueFlag<int> extent(parser, "px", "Tile extent", {"extent"}, 512);
+    args::ValueFlag<int> maxZoom(parser, "zoom", "Maximum zoom", {"max-zoom"}, 16);
+    args::ValueFlag<std::size_t> tileSamples(parser, "count", "getTile calls per zoom", {"tile-samples"}, 1000);
+    args::ValueFlag<std::size_t> leafSamples(parser, "count", "getLeaves calls per zoom", {"leaf-samples"}, 100);
+    args::ValueFlag<unsigned> seed(parser, "seed", "Random seed", {"seed"}, 42);
+    args::Flag perZoom(parser, "per-zoom", "Also report approximate build time per zoom", {"per-zoom"});
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (const args::Help&) {
+        std::cout << parser;
+        return 0;
+    } catch (const args::Error& e) {
+        std::cerr << e.what() << std::endl << parser;
+        return 1;
+    }
+
+    Config config;
+    config.options.radius = static_cast<std::uint16_t>(args::get(radius));
+    config.options.extent = static_cast<std::uint16_t>(args::get(extent));
+    config.options.maxZoom = static_cast<std::uint8_t>(args::get(maxZoom));
+    config.tileSamples = args::get(tileSamples);
+    config.leafSamples = args::get(leafSamples);
+    config.perZoom = perZoom;
+
+    std::vector<std::size_t> counts = args::get(sizes);
+    if (counts.empty()) {
+        counts = {10000, 100000, 1000000};
+    }
+    for (const auto count : counts) {
+        if (count == 0) {
+            std::cerr << "--points must be at least 1" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> selected;
+    for (const auto& name : bench::split(args::get(datasets))) {
+        if (name != "uniform" && name != "hotspots") {
+            std::cerr << "Unknown dataset '" << name << "', expected uniform or hotspots" << std::endl;
+            return 1;
+        }
+        selected.push_back(name);
+    }
+
+    std::vector<point<double>> source;
+    if (geojson && !loadPoints(args::get(geojson), source)) {
+        return 1;
+    }
+
+    // Each dataset is generated and clustered in a child process, so that the peak memory
+    // of one run is not hidden by the high-water mark of an earlier, larger one. Every
+    // child starts from the same seed.
+    auto runDataset = [&](const std::string& name, std::size_t count) {
+        return bench::runIsolated([&](bool isolated) {
+            std::mt19937 rng(args::get(seed));
+            feature_collection<double> features;
+            if (name == "uniform") {
+                features = makeUniform(count, rng);
+            } else if (name == "hotspots") {
+                features = makeHotspots(count, 32, 0.5, rng);
+            } else {
+                features = makeFromSource(source, count, rng);
+            }
+            run(name, features, config, isolated, rng);
+        });
+    };
+
+    for (const auto count : counts) {
+        std::vector<std::string> names = selected;
+        if (!source.empty()) {
+            names.push_back(args::get(geojson));
+        }
+        for (const auto& name : names) {
+            if (!runDataset(name, count)) {
+                std::cerr << "Benchmark of '" << name << "' with " << count << " points failed" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <mapbox/feature.hpp>
+#include <supercluster.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace mapbox {
+namespace base {
+
+/// @cond internal
+namespace internal {
+
+// Minimal protobuf writer covering the wire types used by the vector tile spec.
+class PbfWriter {
+public:
+    explicit PbfWriter(std::string& data) : data_(data) {}
+
+    void addVarint(std::uint64_t value) {
+        while (value >= 0x80u) {
+            data_.push_back(static_cast<char>((value & 0x7fu) | 0x80u));
+            value >>= 7u;
+        }
+        data_.push_back(static_cast<char>(value));
+    }
+
+    void addTag(std::uint32_t field, std::uint32_t wireType) { addVarint((field << 3u) | wireType); }
+
+    void addUInt(std::uint32_t field, std::uint64_t value) {
+        addTag(field, 0);
+        addVarint(value);
+    }
+
+    void addSInt(std::uint32_t field, std::int64_t value) {
+        addTag(field, 0);
+        addVarint(zigzag(value));
+    }
+
+    void addDouble(std::uint32_t field, double value) {
+        addTag(field, 1);
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 8; ++i) {
+            data_.push_back(static_cast<char>(bits & 0xffu));
+            bits >>= 8u;
+        }
+    }
+
+    void addBytes(std::uint32_t field, const std::string& value) {
+        addTag(field, 2);
+        addVarint(value.size());
+        data_.append(value);
+    }
+
+    static std::uint64_t zigzag(std::int64_t value) {
+        return (static_cast<std::uint64_t>(value) << 1u) ^ static_cast<std::uint64_t>(value >> 63);
+    }
+
+private:
+    std::string& data_;
+};
+
+// Encodes a property value as a vector tile `Value` message. Returns false for values
+// the spec cannot represent (null, arrays and objects), which are dropped from the tile.
+class ClusterTileValueEncoder {
+public:
+    explicit ClusterTileValueEncoder(std::string& data) : pbf_(data) {}
+
+    bool operator()(const feature::null_value_t&) { return false; }
+    bool operator()(bool value) {
+        pbf_.addUInt(7, value ? 1u : 0u);
+        return true;
+    }
+    bool operator()(std::uint64_t value) {
+        pbf_.addUInt(5, value);
+        return true;
+    }
+    bool operator()(std::int64_t value) {
+        if (value >= 0) {
+            pbf_.addUInt(5, static_cast<std::uint64_t>(value));
+        } else {
+            pbf_.addSInt(6, value);
+        }
+        return true;
+    }
+    bool operator()(double value) {
+        pbf_.addDouble(3, value);
+        return true;
+    }
+    bool operator()(const std::string& value) {
+        pbf_.addBytes(1, value);
+        return true;
+    }
+    template <typename T>
+    bool operator()(const T&) {
+        return false;
+    }
+
+private:
+    PbfWriter pbf_;
+};
+
+} // namespace internal
+/// @endcond
+
+/**
+ * @brief Encodes a tile returned by \c Supercluster::getTile as a Mapbox Vector Tile.
+ *
+ * Every feature is written as a point into a single layer. Numeric feature ids are kept;
+ * property values that vector tiles cannot hold (null, arrays and objects) are skipped.
+ *
+ * @param tile features of the tile, in tile coordinates
+ * @param layerName name of the vector tile layer
+ * @param extent tile extent, must match \c Options::extent of the index
+ * @return std::string the encoded tile, empty if \a tile has no features
+ */
+inline std::string encodeClusterTile(const feature::feature_collection<std::int16_t>& tile,
+                                     const std::string& layerName = "clusters",
+                                     std::uint32_t extent = 512) {
+    std::string result;
+    if (tile.empty()) {
+        return result;
+    }
+
+    std::string layer;
+    internal::PbfWriter layerPbf(layer);
+    layerPbf.addUInt(15, 2); // version
+    layerPbf.addBytes(1, layerName);
+
+    std::unordered_map<std::string, std::uint32_t> keys;
+    std::unordered_map<std::string, std::uint32_t> values;
+    std::string keysData;
+    std::string valuesData;
+    internal::PbfWriter keysPbf(keysData);
+    internal::PbfWriter valuesPbf(valuesData);
+
+    std::string featureData;
+    std::string packed;
+    std::string value;
+    for (const auto& f : tile) {
+        if (!f.geometry.is<geometry::point<std::int16_t>>()) {
+            continue;
+        }
+        const auto& point = f.geometry.get<geometry::point<std::int16_t>>();
+
+        featureData.clear();
+        internal::PbfWriter featurePbf(featureData);
+        if (f.id.is<std::uint64_t>()) {
+            featurePbf.addUInt(1, f.id.get<std::uint64_t>());
+        } else if (f.id.is<std::int64_t>() && f.id.get<std::int64_t>() >= 0) {
+            featurePbf.addUInt(1, static_cast<std::uint64_t>(f.id.get<std::int64_t>()));
+        }
+
+        packed.clear();
+        internal::PbfWriter tagsPbf(packed);
+        for (const auto& property : f.properties) {
+            value.clear();
+            internal::ClusterTileValueEncoder encoder(value);
+            if (!mapbox::util::apply_visitor(encoder, property.second)) {
+                continue;
+            }
+
+            auto key = keys.emplace(property.first, static_cast<std::uint32_t>(keys.size()));
+            if (key.second) {
+                keysPbf.addBytes(3, property.first);
+            }
+            auto val = values.emplace(value, static_cast<std::uint32_t>(values.size()));
+            if (val.second) {
+                valuesPbf.addBytes(4, value);
+            }
+            tagsPbf.addVarint(key.first->second);
+            tagsPbf.addVarint(val.first->second);
+        }
+        if (!packed.empty()) {
+            featurePbf.addBytes(2, packed);
+        }
+
+        featurePbf.addUInt(3, 1); // GeomType POINT
+
+        packed.clear();
+        internal::PbfWriter geometryPbf(packed);
+        geometryPbf.addVarint((1u << 3u) | 1u); // MoveTo, count 1
+        geometryPbf.addVarint(internal::PbfWriter::zigzag(point.x));
+        geometryPbf.addVarint(internal::PbfWriter::zigzag(point.y));
+        featurePbf.addBytes(4, packed);
+
+        layerPbf.addBytes(2, featureData);
+    }
+
+    layer.append(keysData);
+    layer.append(valuesData);
+    layerPbf.addUInt(5, extent);
+
+    internal::PbfWriter tilePbf(result);
+    tilePbf.addBytes(3, layer);
+    return result;
+}
+
+/**
+ * @brief Thread-safe LRU cache of encoded cluster tiles of a \c Supercluster index.
+ *
+ * Tiles are keyed by z/x/y and encoded on the first request. Rebuilding the index must be
+ * followed by reset(), which drops every cached tile. Tiles that were being encoded from
+ * the previous index while reset() ran are not inserted into the cache.
+ */
+class ClusterTileCache {
+public:
+    using Index = supercluster::Supercluster;
+    using Tile = std::shared_ptr<const std::string>;
+
+    /**
+     * @brief Construct a new \c ClusterTileCache object.
+     *
+     * @param index the index to serve tiles from
+     * @param capacity maximum number of cached tiles
+     * @param layerName name of the vector tile layer
+     */
+    ClusterTileCache(std::shared_ptr<const Index> index, std::size_t capacity, std::string layerName = "clusters")
+        : index_(std::move(index)), capacity_(capacity), layerName_(std::move(layerName)) {
+        assert(index_);
+        assert(capacity_ > 0u);
+    }
+
+    ClusterTileCache(const ClusterTileCache&) = delete;
+    ClusterTileCache& operator=(const ClusterTileCache&) = delete;
+
+    /**
+     * @brief Gets the encoded tile, encoding it if it is not cached.
+     *
+     * An empty string is returned for tiles without features.
+     */
+    Tile getTile(std::uint8_t z, std::uint32_t x, std::uint32_t y) {
+        assert(z < 29u);
+        const std::uint64_t key = (std::uint64_t(z) << 58u) | (std::uint64_t(x) << 29u) | y;
+
+        std::shared_ptr<const Index> index;
+        std::uint64_t generation;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it != entries_.end()) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                return it->second->second;
+            }
+            index = index_;
+            generation = generation_;
+        }
+
+        Tile tile = std::make_shared<const std::string>(
+            encodeClusterTile(index->getTile(z, x, y), layerName_, index->options.extent));
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (generation != generation_ || entries_.count(key) != 0u) {
+            return tile;
+        }
+        lru_.emplace_front(key, tile);
+        entries_.emplace(key, lru_.begin());
+        if (lru_.size() > capacity_) {
+            entries_.erase(lru_.back().first);
+            lru_.pop_back();
+        }
+        return tile;
+    }
+
+    /**
+     * @brief Replaces the index after a rebuild and drops all cached tiles.
+     */
+    void reset(std::shared_ptr<const Index> index) {
+        assert(index);
+        std::lock_guard<std::mutex> lock(mutex_);
+        index_ = std::move(index);
+        ++generation_;
+        entries_.clear();
+        lru_.clear();
+    }
+
+    /**
+     * @brief Number of tiles currently cached.
+     */
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lru_.size();
+    }
+
+private:
+    using Entry = std::pair<std::uint64_t, Tile>;
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Index> index_;
+    std::uint64_t generation_{0u};
+    const std::size_t capacity_;
+    const std::string layerName_;
+    std::list<Entry> lru_;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> entries_;
+};
+
+} // namespace base
+} // namespace mapbox
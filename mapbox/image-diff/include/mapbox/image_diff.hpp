@@ -0,0 +1,514 @@
+#pragma once
+
+#include <mapbox/pixelmatch.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+
+// SIMD detection. The same block is in batch_ruler.hpp; keep the two identical.
+#ifndef MAPBOX_BASE_SIMD_DETECTED
+#define MAPBOX_BASE_SIMD_DETECTED
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MAPBOX_BASE_SSE2
+#include <emmintrin.h>
+#endif
+// AVX is only used through runtime dispatch, which needs GCC or Clang builtins.
+#if defined(MAPBOX_BASE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MAPBOX_BASE_AVX
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define MAPBOX_BASE_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace mapbox {
+namespace base {
+
+/**
+ * @brief Options of \c imageDiff.
+ */
+struct ImageDiffOptions {
+    /// Matching threshold from 0 to 1, as for \c mapbox::pixelmatch. Smaller is stricter.
+    double threshold = 0.1;
+    /// Whether anti-aliased pixels count as differences.
+    bool includeAA = false;
+    /// Number of threads, 0 for one per hardware thread.
+    unsigned threads = 0;
+    /// Number of rows compared as one unit of work.
+    std::size_t bandHeight = 128;
+    /// Stop comparing once more pixels than this mismatch. Checked between runs of
+    /// differing rows, so the returned count may overshoot by the runs in progress.
+    std::uint64_t maxMismatches = std::numeric_limits<std::uint64_t>::max();
+};
+
+/**
+ * @brief Where two images differ, in tiles of \c kTileSize by \c kTileSize pixels.
+ *
+ * Filled by \c imageDiff in the same pass as the comparison, so tools looking for the
+ * changed parts of an image need not scan the diff image again.
+ */
+class ImageDiffSummary {
+public:
+    static constexpr std::uint32_t kTileSize = 32;
+
+    /// Pixel rectangle with inclusive bounds.
+    struct Box {
+        std::uint32_t minX;
+        std::uint32_t minY;
+        std::uint32_t maxX;
+        std::uint32_t maxY;
+    };
+
+    struct Tile {
+        /// Number of mismatched pixels in the tile.
+        std::uint32_t count = 0;
+        /// Bounding box of the mismatched pixels, only valid if \c count is not zero.
+        Box box{0, 0, 0, 0};
+    };
+
+    /**
+     * @brief Clears the summary and sizes it for an image of \a width by \a height pixels.
+     */
+    void reset(std::size_t width, std::size_t height) {
+        columns_ = (width + kTileSize - 1) / kTileSize;
+        rows_ = (height + kTileSize - 1) / kTileSize;
+        tiles_.assign(columns_ * rows_, Tile());
+    }
+
+    /**
+     * @brief Records a mismatched pixel.
+     */
+    void add(std::uint32_t x, std::uint32_t y) {
+        Tile& tile = tiles_[(y / kTileSize) * columns_ + x / kTileSize];
+        if (tile.count++ == 0) {
+            tile.box = {x, y, x, y};
+        } else {
+            tile.box.minX = std::min(tile.box.minX, x);
+            tile.box.minY = std::min(tile.box.minY, y);
+            tile.box.maxX = std::max(tile.box.maxX, x);
+            tile.box.maxY = std::max(tile.box.maxY, y);
+        }
+    }
+
+    /**
+     * @brief Number of tile columns.
+     */
+    std::size_t columns() const { return columns_; }
+
+    /**
+     * @brief Number of tile rows.
+     */
+    std::size_t rows() const { return rows_; }
+
+    /**
+     * @brief The tile at the given tile column and row.
+     */
+    const Tile& tile(std::size_t column, std::size_t row) const { return tiles_[row * columns_ + column]; }
+
+    /**
+     * @brief Bounding boxes of the mismatched pixels of each group of touching tiles,
+     * including diagonal neighbours, in row-major order of their first tile.
+     */
+    std::vector<Box> regions() const {
+        std::vector<Box> result;
+        std::vector<bool> seen(tiles_.size(), false);
+        std::vector<std::size_t> stack;
+        for (std::size_t first = 0; first < tiles_.size(); ++first) {
+            if (tiles_[first].count == 0 || seen[first]) {
+                continue;
+            }
+            Box box = tiles_[first].box;
+            seen[first] = true;
+            stack.push_back(first);
+            while (!stack.empty()) {
+                const std::size_t index = stack.back();
+                stack.pop_back();
+                const Box& tileBox = tiles_[index].box;
+                box = {std::min(box.minX, tileBox.minX),
+                       std::min(box.minY, tileBox.minY),
+                       std::max(box.maxX, tileBox.maxX),
+                       std::max(box.maxY, tileBox.maxY)};
+
+                const std::size_t column = index % columns_;
+                const std::size_t row = index / columns_;
+                for (std::size_t y = row > 0 ? row - 1 : 0; y <= std::min(row + 1, rows_ - 1); ++y) {
+                    for (std::size_t x = column > 0 ? column - 1 : 0; x <= std::min(column + 1, columns_ - 1); ++x) {
+                        const std::size_t neighbour = y * columns_ + x;
+                        if (tiles_[neighbour].count != 0 && !seen[neighbour]) {
+                            seen[neighbour] = true;
+                            stack.push_back(neighbour);
+                        }
+                    }
+                }
+            }
+            result.push_back(box);
+        }
+        return result;
+    }
+
+private:
+    std::size_t columns_ = 0;
+    std::size_t rows_ = 0;
+    std::vector<Tile> tiles_;
+};
+
+/// @cond internal
+namespace internal {
+
+// pixelmatch looks up to two pixels away from a pixel when it decides whether the pixel is
+// anti-aliased: one for its own neighbours and one more for theirs.
+constexpr std::size_t kImageDiffHalo = 2;
+
+// Rows after which a group of differing rows is cut while few of its columns differ.
+// Shorter groups keep the windows narrow around edges that are not vertical, at the cost
+// of the halo rows that neighbouring groups both compare.
+constexpr std::size_t kImageDiffGroupRows = 8;
+
+// Buffers reused by one thread across the windows it compares.
+struct ImageDiffScratch {
+    std::vector<std::uint8_t> img1;
+    std::vector<std::uint8_t> img2;
+    std::vector<std::uint8_t> output;
+    // Per column, whether it differs in any row of the current group, and how many do.
+    std::vector<std::uint8_t> changed;
+    std::size_t changedCount = 0;
+};
+
+// Index of the first pixel at or after x whose 32-bit RGBA words differ, or width. Four
+// pixels are compared per instruction where SSE2 or NEON is available.
+inline std::size_t imageDiffFirstDifferent(const std::uint8_t* row1,
+                                           const std::uint8_t* row2,
+                                           std::size_t x,
+                                           std::size_t width) {
+#if defined(MAPBOX_BASE_SSE2)
+    for (; x + 4 <= width; x += 4) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 4));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row2 + x * 4));
+        const int equal = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+        if (equal != 0xf) {
+            break;
+        }
+    }
+#elif defined(MAPBOX_BASE_NEON)
+    for (; x + 4 <= width; x += 4) {
+        const uint32x4_t a = vld1q_u32(reinterpret_cast<const std::uint32_t*>(row1 + x * 4));
+        const uint32x4_t b = vld1q_u32(reinterpret_cast<const std::uint32_t*>(row2 + x * 4));
+        if (vminvq_u32(vceqq_u32(a, b)) == 0) {
+            break;
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        std::uint32_t a;
+        std::uint32_t b;
+        std::memcpy(&a, row1 + x * 4, sizeof(a));
+        std::memcpy(&b, row2 + x * 4, sizeof(b));
+        if (a != b) {
+            return x;
+        }
+    }
+    return width;
+}
+
+// Draws the output of pixels [left, right) of rows [top, bottom) that are identical in
+// both images. Those pixels only need the grey background, which is what pixelmatch draws
+// when comparing an image with itself.
+inline void imageDiffBackground(const std::uint8_t* img,
+                                std::size_t width,
+                                std::size_t left,
+                                std::size_t right,
+                                std::size_t top,
+                                std::size_t bottom,
+                                std::uint8_t* output,
+                                double threshold) {
+    const std::size_t rowBytes = width * 4;
+    if (left == 0 && right == width) {
+        const std::uint8_t* rows = img + top * rowBytes;
+        ::mapbox::pixelmatch(rows, rows, width, bottom - top, output + top * rowBytes, threshold);
+        return;
+    }
+    for (std::size_t y = top; y < bottom; ++y) {
+        const std::uint8_t* pixels = img + y * rowBytes + left * 4;
+        ::mapbox::pixelmatch(pixels, pixels, right - left, 1, output + y * rowBytes + left * 4, threshold);
+    }
+}
+
+// Compares pixels [left, right) of rows [begin, end) by running pixelmatch on them and on
+// the halo around them, then counting, summarising and copying only the pixels inside.
+// The halo sees a clipped neighbourhood, but no pixel inside depends on that. Windows
+// narrower than the image are copied into scratch first, since pixelmatch takes whole
+// images.
+inline std::uint64_t imageDiffWindow(const std::uint8_t* img1,
+                                     const std::uint8_t* img2,
+                                     std::size_t width,
+                                     std::size_t height,
+                                     std::size_t left,
+                                     std::size_t right,
+                                     std::size_t begin,
+                                     std::size_t end,
+                                     std::uint8_t* output,
+                                     ImageDiffSummary* summary,
+                                     const ImageDiffOptions& options,
+                                     ImageDiffScratch& scratch) {
+    const std::size_t rowBytes = width * 4;
+    const std::size_t top = begin > kImageDiffHalo ? begin - kImageDiffHalo : 0;
+    const std::size_t bottom = std::min(height, end + kImageDiffHalo);
+    const std::size_t windowLeft = left > kImageDiffHalo ? left - kImageDiffHalo : 0;
+    const std::size_t windowWidth = std::min(width, right + kImageDiffHalo) - windowLeft;
+    const std::size_t windowRowBytes = windowWidth * 4;
+
+    const std::uint8_t* window1 = img1 + top * rowBytes;
+    const std::uint8_t* window2 = img2 + top * rowBytes;
+    if (windowWidth != width) {
+        scratch.img1.resize((bottom - top) * windowRowBytes);
+        scratch.img2.resize((bottom - top) * windowRowBytes);
+        for (std::size_t y = top; y < bottom; ++y) {
+            const std::size_t offset = y * rowBytes + windowLeft * 4;
+            std::memcpy(scratch.img1.data() + (y - top) * windowRowBytes, img1 + offset, windowRowBytes);
+            std::memcpy(scratch.img2.data() + (y - top) * windowRowBytes, img2 + offset, windowRowBytes);
+        }
+        window1 = scratch.img1.data();
+        window2 = scratch.img2.data();
+    }
+    scratch.output.resize((bottom - top) * windowRowBytes);
+    ::mapbox::pixelmatch(
+        window1, window2, windowWidth, bottom - top, scratch.output.data(), options.threshold, options.includeAA);
+
+    // Mismatches are the only pixels pixelmatch paints pure red.
+    std::uint64_t count = 0;
+    for (std::size_t y = begin; y < end; ++y) {
+        const std::uint8_t* row = scratch.output.data() + (y - top) * windowRowBytes + (left - windowLeft) * 4;
+        const std::uint8_t* pixel = row;
+        for (std::size_t x = left; x < right; ++x, pixel += 4) {
+            if (pixel[0] == 255 && pixel[1] == 0 && pixel[2] == 0) {
+                ++count;
+                if (summary) {
+                    summary->add(static_cast<std::uint32_t>(x), static_cast<std::uint32_t>(y));
+                }
+            }
+        }
+        if (output) {
+            std::memcpy(output + y * rowBytes + left * 4, row, (right - left) * 4);
+        }
+    }
+    return count;
+}
+
+// Marks the columns in which row y differs in scratch.changed.
+inline void imageDiffMarkColumns(const std::uint8_t* img1,
+                                 const std::uint8_t* img2,
+                                 std::size_t width,
+                                 std::size_t y,
+                                 ImageDiffScratch& scratch) {
+    const std::uint8_t* row1 = img1 + y * width * 4;
+    const std::uint8_t* row2 = img2 + y * width * 4;
+    for (std::size_t x = imageDiffFirstDifferent(row1, row2, 0, width); x < width;
+         x = imageDiffFirstDifferent(row1, row2, x + 1, width)) {
+        if (!scratch.changed[x]) {
+            scratch.changed[x] = 1;
+            ++scratch.changedCount;
+        }
+    }
+}
+
+// Compares a group of rows [begin, end), whose differing columns are marked in
+// scratch.changed. A pixel that is byte-identical in both images is never a mismatch, so
+// only those columns go to pixelmatch, in spans that are merged when their windows would
+// overlap anyway.
+inline std::uint64_t imageDiffRows(const std::uint8_t* img1,
+                                   const std::uint8_t* img2,
+                                   std::size_t width,
+                                   std::size_t height,
+                                   std::size_t begin,
+                                   std::size_t end,
+                                   std::uint8_t* output,
+                                   ImageDiffSummary* summary,
+                                   const ImageDiffOptions& options,
+                                   ImageDiffScratch& scratch) {
+    const std::vector<std::uint8_t>& changed = scratch.changed;
+    std::uint64_t count = 0;
+    std::size_t column = 0;
+    while (column < width) {
+        std::size_t left = column;
+        while (left < width && !changed[left]) {
+            ++left;
+        }
+        if (output && left > column) {
+            imageDiffBackground(img1, width, column, left, begin, end, output, options.threshold);
+        }
+        if (left == width) {
+            break;
+        }
+        std::size_t last = left;
+        for (std::size_t next = left + 1; next < width && next - last <= 2 * kImageDiffHalo; ++next) {
+            if (changed[next]) {
+                last = next;
+            }
+        }
+        count +=
+            imageDiffWindow(img1, img2, width, height, left, last + 1, begin, end, output, summary, options, scratch);
+        column = last + 1;
+    }
+    return count;
+}
+
+// Compares rows [begin, end) and adds their mismatches to total. Rows are first compared
+// with memcmp; identical rows only need the grey background, and differing rows closer
+// than two halos are compared as one group, since their windows would overlap anyway.
+inline void imageDiffBand(const std::uint8_t* img1,
+                          const std::uint8_t* img2,
+                          std::size_t width,
+                          std::size_t height,
+                          std::size_t begin,
+                          std::size_t end,
+                          std::uint8_t* output,
+                          ImageDiffSummary* summary,
+                          const ImageDiffOptions& options,
+                          ImageDiffScratch& scratch,
+                          std::atomic<std::uint64_t>& total) {
+    const std::size_t rowBytes = width * 4;
+    auto same = [&](std::size_t row) {
+        return std::memcmp(img1 + row * rowBytes, img2 + row * rowBytes, rowBytes) == 0;
+    };
+
+    std::size_t row = begin;
+    while (row < end && total.load(std::memory_order_relaxed) <= options.maxMismatches) {
+        std::size_t next = row;
+        while (next < end && same(next)) {
+            ++next;
+        }
+        if (output && next > row) {
+            imageDiffBackground(img1, width, 0, width, row, next, output, options.threshold);
+        }
+        if (next == end) {
+            break;
+        }
+
+        row = next;
+        std::size_t last = row;
+        scratch.changed.assign(width, 0);
+        scratch.changedCount = 0;
+        imageDiffMarkColumns(img1, img2, width, row, scratch);
+        for (next = row + 1; next < end && next - last <= 2 * kImageDiffHalo; ++next) {
+            if (next - row >= kImageDiffGroupRows && scratch.changedCount * 2 < width) {
+                break;
+            }
+            if (!same(next)) {
+                last = next;
+                imageDiffMarkColumns(img1, img2, width, next, scratch);
+            }
+        }
+        total += imageDiffRows(img1, img2, width, height, row, last + 1, output, summary, options, scratch);
+        row = last + 1;
+    }
+}
+
+} // namespace internal
+/// @endcond
+
+/**
+ * @brief Compares two RGBA images like \c mapbox::pixelmatch, using several threads.
+ *
+ * The images are split into bands of \c ImageDiffOptions::bandHeight rows, which worker
+ * threads take in turn. Rows that are byte-identical in both images are recognised with
+ * \c memcmp, and within the other rows the columns that differ are found four pixels at
+ * a time with SSE2 or NEON. \c mapbox::pixelmatch then runs only on windows around those
+ * columns, with two more rows and columns on every side, so that anti-aliasing detection
+ * sees the same neighbourhood as in a single pass. Identical pixels only get the grey
+ * background, drawn by \c mapbox::pixelmatch comparing the first image with itself. The
+ * count and the output image are identical to those of \c mapbox::pixelmatch.
+ *
+ * Once the count exceeds \c ImageDiffOptions::maxMismatches, no further work is started
+ * and the count so far is returned. The output image and summary are then incomplete.
+ *
+ * @param img1 first image, `width * height * 4` bytes
+ * @param img2 second image of the same size
+ * @param width image width in pixels
+ * @param height image height in pixels
+ * @param output optional diff image of the same size
+ * @param summary optional per-tile summary of the mismatches
+ * @param options comparison options
+ * @return number of mismatched pixels, or a number above \c ImageDiffOptions::maxMismatches
+ * if the comparison stopped early
+ */
+inline std::uint64_t imageDiff(const std::uint8_t* img1,
+                               const std::uint8_t* img2,
+                               std::size_t width,
+                               std::size_t height,
+                               std::uint8_t* output,
+                               ImageDiffSummary* summary,
+                               const ImageDiffOptions& options = {}) {
+    assert(options.bandHeight > 0u);
+    // Bands cover whole tile rows, so that no two threads update the same tile.
+    std::size_t bandHeight = options.bandHeight;
+    if (summary) {
+        summary->reset(width, height);
+        const std::size_t tileSize = ImageDiffSummary::kTileSize;
+        bandHeight = (bandHeight + tileSize - 1) / tileSize * tileSize;
+    }
+    const std::size_t bands = (height + bandHeight - 1) / bandHeight;
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, bands));
+
+    std::atomic<std::size_t> next(0);
+    std::atomic<std::uint64_t> total(0);
+    auto work = [&] {
+        internal::ImageDiffScratch scratch;
+        for (std::size_t band = next++; band < bands && total.load(std::memory_order_relaxed) <= options.maxMismatches;
+             band = next++) {
+            const std::size_t begin = band * bandHeight;
+            const std::size_t end = std::min(height, begin + bandHeight);
+            internal::imageDiffBand(img1, img2, width, height, begin, end, output, summary, options, scratch, total);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return total;
+}
+
+/**
+ * @brief Compares two RGBA images like \c mapbox::pixelmatch, using several threads.
+ */
+inline std::uint64_t imageDiff(const std::uint8_t* img1,
+                               const std::uint8_t* img2,
+                               std::size_t width,
+                               std::size_t height,
+                               std::uint8_t* output = nullptr,
+                               const ImageDiffOptions& options = {}) {
+    return imageDiff(img1, img2, width, height, output, nullptr, options);
+}
+
+/**
+ * @brief Whether at most \a maxMismatches pixels differ between two RGBA images.
+ *
+ * Stops as soon as the answer is known and produces no diff image, which makes it the
+ * cheapest way to check an image against a tolerance.
+ */
+inline bool imagesMatch(const std::uint8_t* img1,
+                        const std::uint8_t* img2,
+                        std::size_t width,
+                        std::size_t height,
+                        std::uint64_t maxMismatches = 0,
+                        ImageDiffOptions options = {}) {
+    options.maxMismatches = maxMismatches;
+    return imageDiff(img1, img2, width, height, nullptr, options) <= maxMismatches;
+}
+
+} // namespace base
+} // namespace mapbox
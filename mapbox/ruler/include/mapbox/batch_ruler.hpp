@@ -0,0 +1,234 @@
+#pragma once
+
+#include <mapbox/cheap_ruler.hpp>
+
+#include <cmath>
+#include <cstddef>
+
+// SIMD detection. The same block is in image_diff.hpp; keep the two identical.
+#ifndef MAPBOX_BASE_SIMD_DETECTED
+#define MAPBOX_BASE_SIMD_DETECTED
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MAPBOX_BASE_SSE2
+#include <emmintrin.h>
+#endif
+// AVX is only used through runtime dispatch, which needs GCC or Clang builtins.
+#if defined(MAPBOX_BASE_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MAPBOX_BASE_AVX
+#include <immintrin.h>
+#endif
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define MAPBOX_BASE_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace mapbox {
+namespace base {
+
+/// @cond internal
+namespace internal {
+
+// All kernels compute out[i] = |((bx - ax) * kx, (by - ay) * ky)| for i in [begin, count),
+// where b is read at index i * bStep, so bStep 0 measures from a single point. The vector
+// versions never fuse the multiplications and additions, so they match the scalar loop
+// exactly unless the compiler contracts it into FMA instructions.
+struct ScaledDistanceArgs {
+    const double* ax;
+    const double* ay;
+    const double* bx;
+    const double* by;
+    std::size_t bStep;
+    double kx;
+    double ky;
+    double* out;
+};
+
+inline void scaledDistancesScalar(const ScaledDistanceArgs& a, std::size_t begin, std::size_t count) {
+    for (std::size_t i = begin; i < count; ++i) {
+        const double dx = (a.bx[i * a.bStep] - a.ax[i]) * a.kx;
+        const double dy = (a.by[i * a.bStep] - a.ay[i]) * a.ky;
+        a.out[i] = std::sqrt(dx * dx + dy * dy);
+    }
+}
+
+#if defined(MAPBOX_BASE_SSE2)
+inline void scaledDistancesSse2(const ScaledDistanceArgs& a, std::size_t count) {
+    const __m128d kx = _mm_set1_pd(a.kx);
+    const __m128d ky = _mm_set1_pd(a.ky);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128d bx = a.bStep ? _mm_loadu_pd(a.bx + i) : _mm_set1_pd(a.bx[0]);
+        const __m128d by = a.bStep ? _mm_loadu_pd(a.by + i) : _mm_set1_pd(a.by[0]);
+        const __m128d dx = _mm_mul_pd(_mm_sub_pd(bx, _mm_loadu_pd(a.ax + i)), kx);
+        const __m128d dy = _mm_mul_pd(_mm_sub_pd(by, _mm_loadu_pd(a.ay + i)), ky);
+        _mm_storeu_pd(a.out + i, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+    }
+    scaledDistancesScalar(a, i, count);
+}
+#endif
+
+#if defined(MAPBOX_BASE_AVX)
+__attribute__((target("avx"))) inline void scaledDistancesAvx(const ScaledDistanceArgs& a, std::size_t count) {
+    const __m256d kx = _mm256_set1_pd(a.kx);
+    const __m256d ky = _mm256_set1_pd(a.ky);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256d bx = a.bStep ? _mm256_loadu_pd(a.bx + i) : _mm256_set1_pd(a.bx[0]);
+        const __m256d by = a.bStep ? _mm256_loadu_pd(a.by + i) : _mm256_set1_pd(a.by[0]);
+        const __m256d dx = _mm256_mul_pd(_mm256_sub_pd(bx, _mm256_loadu_pd(a.ax + i)), kx);
+        const __m256d dy = _mm256_mul_pd(_mm256_sub_pd(by, _mm256_loadu_pd(a.ay + i)), ky);
+        _mm256_storeu_pd(a.out + i, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+    }
+    scaledDistancesScalar(a, i, count);
+}
+#endif
+
+#if defined(MAPBOX_BASE_NEON)
+inline void scaledDistancesNeon(const ScaledDistanceArgs& a, std::size_t count) {
+    const float64x2_t kx = vdupq_n_f64(a.kx);
+    const float64x2_t ky = vdupq_n_f64(a.ky);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const float64x2_t bx = a.bStep ? vld1q_f64(a.bx + i) : vdupq_n_f64(a.bx[0]);
+        const float64x2_t by = a.bStep ? vld1q_f64(a.by + i) : vdupq_n_f64(a.by[0]);
+        const float64x2_t dx = vmulq_f64(vsubq_f64(bx, vld1q_f64(a.ax + i)), kx);
+        const float64x2_t dy = vmulq_f64(vsubq_f64(by, vld1q_f64(a.ay + i)), ky);
+        vst1q_f64(a.out + i, vsqrtq_f64(vaddq_f64(vmulq_f64(dx, dx), vmulq_f64(dy, dy))));
+    }
+    scaledDistancesScalar(a, i, count);
+}
+#endif
+
+using ScaledDistancesKernel = void (*)(const ScaledDistanceArgs&, std::size_t);
+
+inline void scaledDistancesPortable(const ScaledDistanceArgs& a, std::size_t count) {
+    scaledDistancesScalar(a, 0, count);
+}
+
+// Picks the widest kernel the build and the CPU support, once per process.
+inline ScaledDistancesKernel scaledDistancesKernel() {
+    static const ScaledDistancesKernel kernel = [] {
+#if defined(MAPBOX_BASE_AVX)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx")) {
+            return static_cast<ScaledDistancesKernel>(&scaledDistancesAvx);
+        }
+#endif
+#if defined(MAPBOX_BASE_SSE2)
+        return static_cast<ScaledDistancesKernel>(&scaledDistancesSse2);
+#elif defined(MAPBOX_BASE_NEON)
+        return static_cast<ScaledDistancesKernel>(&scaledDistancesNeon);
+#else
+        return static_cast<ScaledDistancesKernel>(&scaledDistancesPortable);
+#endif
+    }();
+    return kernel;
+}
+
+} // namespace internal
+/// @endcond
+
+/**
+ * @brief Measures many distances at once with the multipliers of a \c CheapRuler.
+ *
+ * Coordinates are passed as separate arrays of longitudes and latitudes (structure of
+ * arrays), which lets the measurements run several at a time in SIMD registers. SSE2 is
+ * used on x86 and NEON on 64-bit ARM, with a scalar fallback elsewhere. When built with
+ * GCC or Clang, AVX is used instead of SSE2 if the CPU supports it; other compilers,
+ * including MSVC and clang-cl, stay on SSE2. Results match \c CheapRuler::distance and
+ * \c CheapRuler::lineDistance up to rounding.
+ *
+ * Like \c CheapRuler, longitudes are not wrapped around the antimeridian.
+ */
+class BatchRuler {
+public:
+    /**
+     * @brief Construct a new \c BatchRuler object with the multipliers of \a ruler.
+     */
+    explicit BatchRuler(cheap_ruler::CheapRuler ruler)
+        : kx_(ruler.distance({0.0, 0.0}, {1.0, 0.0})), ky_(ruler.distance({0.0, 0.0}, {0.0, 1.0})) {}
+
+    /**
+     * @brief Construct a new \c BatchRuler object for the given latitude.
+     */
+    explicit BatchRuler(double latitude, cheap_ruler::CheapRuler::Unit unit = cheap_ruler::CheapRuler::Kilometers)
+        : BatchRuler(cheap_ruler::CheapRuler(latitude, unit)) {}
+
+    /**
+     * @brief Distance covered by one degree of longitude.
+     */
+    double kx() const { return kx_; }
+
+    /**
+     * @brief Distance covered by one degree of latitude.
+     */
+    double ky() const { return ky_; }
+
+    /**
+     * @brief Distances from \a from to each of \a count points.
+     *
+     * @param from the point to measure from
+     * @param xs longitudes of the points
+     * @param ys latitudes of the points
+     * @param count number of points
+     * @param out receives \a count distances, may alias neither \a xs nor \a ys
+     */
+    void distances(cheap_ruler::point from, const double* xs, const double* ys, std::size_t count, double* out) const {
+        run({xs, ys, &from.x, &from.y, 0, kx_, ky_, out}, count);
+    }
+
+    /**
+     * @brief Pairwise distances between `(ax[i], ay[i])` and `(bx[i], by[i])`.
+     */
+    void distances(const double* ax,
+                   const double* ay,
+                   const double* bx,
+                   const double* by,
+                   std::size_t count,
+                   double* out) const {
+        run({ax, ay, bx, by, 1, kx_, ky_, out}, count);
+    }
+
+    /**
+     * @brief Length of each of the `count - 1` segments of a line.
+     *
+     * @param out receives `count - 1` lengths
+     */
+    void segmentLengths(const double* xs, const double* ys, std::size_t count, double* out) const {
+        if (count > 1) {
+            run({xs, ys, xs + 1, ys + 1, 1, kx_, ky_, out}, count - 1);
+        }
+    }
+
+    /**
+     * @brief Total length of a line.
+     *
+     * Segment lengths are computed in blocks and summed in order, like
+     * \c CheapRuler::lineDistance does.
+     */
+    double lineDistance(const double* xs, const double* ys, std::size_t count) const {
+        constexpr std::size_t kBlock = 256;
+        double lengths[kBlock];
+        double total = 0.0;
+        for (std::size_t first = 0; first + 1 < count; first += kBlock) {
+            const std::size_t points = count - first < kBlock + 1 ? count - first : kBlock + 1;
+            segmentLengths(xs + first, ys + first, points, lengths);
+            for (std::size_t i = 0; i + 1 < points; ++i) {
+                total += lengths[i];
+            }
+        }
+        return total;
+    }
+
+private:
+    static void run(const internal::ScaledDistanceArgs& args, std::size_t count) {
+        internal::scaledDistancesKernel()(args, count);
+    }
+
+    double kx_;
+    double ky_;
+};
+
+} // namespace base
+} // namespace mapbox
@@ -0,0 +1,731 @@
+#pragma once
+
+#include <mapbox/cheap_ruler.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
+#include <limits>
+#include <tuple>
+
+namespace mapbox {
+namespace base {
+
+/// @cond internal
+namespace internal {
+
+// WGS84 ellipsoid, in metres.
+constexpr double kWgs84A = 6378137.0;
+constexpr double kWgs84F = 1.0 / 298.257223563;
+constexpr double kWgs84B = kWgs84A * (1.0 - kWgs84F);
+constexpr double kRadians = M_PI / 180.0;
+constexpr double kWgs84E2 = kWgs84F * (2.0 - kWgs84F);
+
+struct GeodesicInverse {
+    double distance; // metres
+    double azimuth;  // initial azimuth, radians
+};
+
+inline void vincentyCoefficients(double cosSqAlpha, double& a, double& b) {
+    const double uSq = cosSqAlpha * (kWgs84A * kWgs84A - kWgs84B * kWgs84B) / (kWgs84B * kWgs84B);
+    a = 1.0 + uSq / 16384.0 * (4096.0 + uSq * (-768.0 + uSq * (320.0 - 175.0 * uSq)));
+    b = uSq / 1024.0 * (256.0 + uSq * (-128.0 + uSq * (74.0 - 47.0 * uSq)));
+}
+
+inline double vincentyDeltaSigma(double b, double sinSigma, double cosSigma, double cos2SigmaM) {
+    const double c2 = cos2SigmaM * cos2SigmaM;
+    return b * sinSigma *
+           (cos2SigmaM + b / 4.0 *
+                             (cosSigma * (-1.0 + 2.0 * c2) -
+                              b / 6.0 * cos2SigmaM * (-3.0 + 4.0 * sinSigma * sinSigma) * (-3.0 + 4.0 * c2)));
+}
+
+// Vincenty's inverse formula. For nearly antipodal points the iteration may not
+// converge, in which case the last iterate is used.
+inline GeodesicInverse vincentyInverse(cheap_ruler::point p1, cheap_ruler::point p2) {
+    const double l = std::remainder(p2.x - p1.x, 360.0) * kRadians;
+    const double u1 = std::atan((1.0 - kWgs84F) * std::tan(p1.y * kRadians));
+    const double u2 = std::atan((1.0 - kWgs84F) * std::tan(p2.y * kRadians));
+    const double sinU1 = std::sin(u1);
+    const double cosU1 = std::cos(u1);
+    const double sinU2 = std::sin(u2);
+    const double cosU2 = std::cos(u2);
+
+    double lambda = l;
+    double sinLambda = 0.0;
+    double cosLambda = 0.0;
+    double sinSigma = 0.0;
+    double cosSigma = 0.0;
+    double sigma = 0.0;
+    double cosSqAlpha = 0.0;
+    double cos2SigmaM = 0.0;
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        sinLambda = std::sin(lambda);
+        cosLambda = std::cos(lambda);
+        const double t = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+        sinSigma = std::sqrt(cosU2 * sinLambda * cosU2 * sinLambda + t * t);
+        if (sinSigma == 0.0) {
+            return {0.0, 0.0};
+        }
+        cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+        sigma = std::atan2(sinSigma, cosSigma);
+        const double sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+        cosSqAlpha = 1.0 - sinAlpha * sinAlpha;
+        // Zero on equatorial lines.
+        cos2SigmaM = cosSqAlpha != 0.0 ? cosSigma - 2.0 * sinU1 * sinU2 / cosSqAlpha : 0.0;
+        const double c = kWgs84F / 16.0 * cosSqAlpha * (4.0 + kWgs84F * (4.0 - 3.0 * cosSqAlpha));
+        const double previous = lambda;
+        lambda = l + (1.0 - c) * kWgs84F * sinAlpha *
+                         (sigma + c * sinSigma * (cos2SigmaM + c * cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM)));
+        if (std::abs(lambda - previous) <= 1e-12) {
+            break;
+        }
+    }
+
+    double a = 0.0;
+    double b = 0.0;
+    vincentyCoefficients(cosSqAlpha, a, b);
+    const double deltaSigma = vincentyDeltaSigma(b, sinSigma, cosSigma, cos2SigmaM);
+    return {kWgs84B * a * (sigma - deltaSigma),
+            std::atan2(cosU2 * sinLambda, cosU1 * sinU2 - sinU1 * cosU2 * cosLambda)};
+}
+
+// Vincenty's direct formula. Stores the azimuth at the destination in \a finalAzimuth
+// if given.
+inline cheap_ruler::point vincentyDirect(cheap_ruler::point origin,
+                                         double azimuth,
+                                         double distance,
+                                         double* finalAzimuth = nullptr) {
+    const double sinAlpha1 = std::sin(azimuth);
+    const double cosAlpha1 = std::cos(azimuth);
+    const double tanU1 = (1.0 - kWgs84F) * std::tan(origin.y * kRadians);
+    const double cosU1 = 1.0 / std::sqrt(1.0 + tanU1 * tanU1);
+    const double sinU1 = tanU1 * cosU1;
+    const double sigma1 = std::atan2(tanU1, cosAlpha1);
+    const double sinAlpha = cosU1 * sinAlpha1;
+    const double cosSqAlpha = 1.0 - sinAlpha * sinAlpha;
+
+    double a = 0.0;
+    double b = 0.0;
+    vincentyCoefficients(cosSqAlpha, a, b);
+
+    double sigma = distance / (kWgs84B * a);
+    double sinSigma = 0.0;
+    double cosSigma = 0.0;
+    double cos2SigmaM = 0.0;
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        cos2SigmaM = std::cos(2.0 * sigma1 + sigma);
+        sinSigma = std::sin(sigma);
+        cosSigma = std::cos(sigma);
+        const double previous = sigma;
+        sigma = distance / (kWgs84B * a) + vincentyDeltaSigma(b, sinSigma, cosSigma, cos2SigmaM);
+        if (std::abs(sigma - previous) <= 1e-12) {
+            break;
+        }
+    }
+    sinSigma = std::sin(sigma);
+    cosSigma = std::cos(sigma);
+    cos2SigmaM = std::cos(2.0 * sigma1 + sigma);
+
+    const double t = sinU1 * sinSigma - cosU1 * cosSigma * cosAlpha1;
+    const double lat = std::atan2(sinU1 * cosSigma + cosU1 * sinSigma * cosAlpha1,
+                                  (1.0 - kWgs84F) * std::sqrt(sinAlpha * sinAlpha + t * t));
+    const double lambda = std::atan2(sinSigma * sinAlpha1, cosU1 * cosSigma - sinU1 * sinSigma * cosAlpha1);
+    const double c = kWgs84F / 16.0 * cosSqAlpha * (4.0 + kWgs84F * (4.0 - 3.0 * cosSqAlpha));
+    const double l =
+        lambda - (1.0 - c) * kWgs84F * sinAlpha *
+                     (sigma + c * sinSigma * (cos2SigmaM + c * cosSigma * (-1.0 + 2.0 * cos2SigmaM * cos2SigmaM)));
+    if (finalAzimuth) {
+        *finalAzimuth = std::atan2(sinAlpha, -t);
+    }
+    return {origin.x + l / kRadians, lat / kRadians};
+}
+
+// Authalic latitude support: q(φ) of the WGS84 ellipsoid, as in Snyder's "Map
+// Projections - A Working Manual", eq. 3-12.
+inline double authalicQ(double sinLatitude) {
+    const double e = std::sqrt(kWgs84E2);
+    const double es = e * sinLatitude;
+    return (1.0 - kWgs84E2) *
+           (sinLatitude / (1.0 - es * es) - 1.0 / (2.0 * e) * std::log((1.0 - es) / (1.0 + es)));
+}
+
+// Signed area in steradians between a great circle arc on the authalic sphere and the
+// equator. Summed over a closed ring, it gives the area the ring encloses.
+inline double authalicEdgeArea(cheap_ruler::point a, cheap_ruler::point b) {
+    const double qp = authalicQ(1.0);
+    const double xi1 = std::asin(std::max(-1.0, std::min(1.0, authalicQ(std::sin(a.y * kRadians)) / qp)));
+    const double xi2 = std::asin(std::max(-1.0, std::min(1.0, authalicQ(std::sin(b.y * kRadians)) / qp)));
+    const double t1 = std::tan(xi1 / 2.0);
+    const double t2 = std::tan(xi2 / 2.0);
+    const double dLambda = std::remainder(b.x - a.x, 360.0) * kRadians;
+    return 2.0 * std::atan2(std::tan(dLambda / 2.0) * (t1 + t2), 1.0 + t1 * t2);
+}
+
+// Ruler units per kilometre.
+inline double unitsPerKilometre(cheap_ruler::CheapRuler::Unit unit) {
+    return cheap_ruler::CheapRuler(0.0, unit).distance({0.0, 0.0}, {1.0, 0.0}) /
+           cheap_ruler::CheapRuler(0.0).distance({0.0, 0.0}, {1.0, 0.0});
+}
+
+} // namespace internal
+/// @endcond
+
+/**
+ * @brief Ellipsoidal measurements with the interface of \c CheapRuler.
+ *
+ * Distances, bearings and destinations are solved on the WGS84 ellipsoid with Vincenty's
+ * formulae, which are accurate to well below a millimetre at any distance, except for
+ * nearly antipodal points where the inverse solution may not converge. Lines are
+ * geodesics between their points. Unlike \c CheapRuler, the result does not depend on a
+ * reference latitude.
+ *
+ * Areas are exact for polygons whose edges are great circles of the authalic sphere,
+ * which differ from ellipsoidal geodesics by a small fraction of the flattening.
+ *
+ * \c CheapRuler::offset has no counterpart, since east and north offsets do not compose
+ * on the ellipsoid. Use destination() instead. The static \c CheapRuler::insideBBox and
+ * \c CheapRuler::interpolate do not measure anything and apply as they are.
+ */
+class GeodesicRuler {
+public:
+    /**
+     * @brief Construct a new \c GeodesicRuler object measuring in \a unit.
+     */
+    explicit GeodesicRuler(cheap_ruler::CheapRuler::Unit unit = cheap_ruler::CheapRuler::Kilometers)
+        : unitsPerMetre_(internal::unitsPerKilometre(unit) / 1000.0) {}
+
+    /**
+     * @brief Distance between two points.
+     */
+    double distance(cheap_ruler::point a, cheap_ruler::point b) const {
+        return internal::vincentyInverse(a, b).distance * unitsPerMetre_;
+    }
+
+    /**
+     * @brief Initial bearing from \a a to \a b in degrees, from -180 to 180.
+     */
+    double bearing(cheap_ruler::point a, cheap_ruler::point b) const {
+        return internal::vincentyInverse(a, b).azimuth / internal::kRadians;
+    }
+
+    /**
+     * @brief The point at distance \a dist and initial bearing \a bearing from \a origin.
+     */
+    cheap_ruler::point destination(cheap_ruler::point origin, double dist, double bearing) const {
+        return internal::vincentyDirect(origin, bearing * internal::kRadians, dist / unitsPerMetre_);
+    }
+
+    /**
+     * @brief Total length of a line.
+     */
+    double lineDistance(const cheap_ruler::line_string& points) const {
+        double total = 0.0;
+        for (std::size_t i = 0; i + 1 < points.size(); ++i) {
+            total += distance(points[i], points[i + 1]);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Area of a polygon, in square units.
+     *
+     * Holes are subtracted whatever their winding. Each ring encloses the smaller of the
+     * two parts it divides the globe into.
+     */
+    double area(const cheap_ruler::polygon& poly) const {
+        const double qp = internal::authalicQ(1.0);
+        const double radiusSq = internal::kWgs84A * internal::kWgs84A * qp / 2.0 * unitsPerMetre_ * unitsPerMetre_;
+        double sum = 0.0;
+        for (std::size_t i = 0; i < poly.size(); ++i) {
+            const auto& ring = poly[i];
+            double excess = 0.0;
+            double winding = 0.0;
+            for (std::size_t j = 0, k = ring.size() - 1; j < ring.size(); k = j++) {
+                excess += internal::authalicEdgeArea(ring[k], ring[j]);
+                winding += std::remainder(ring[j].x - ring[k].x, 360.0);
+            }
+            // A ring around a pole measures the area between itself and the equator.
+            double ringArea = std::abs(winding) > 180.0 ? 2.0 * M_PI - std::abs(excess) : std::abs(excess);
+            ringArea = std::min(ringArea, 4.0 * M_PI - ringArea);
+            sum += i == 0 ? ringArea : -ringArea;
+        }
+        return std::max(0.0, sum) * radiusSq;
+    }
+
+    /**
+     * @brief The point at distance \a dist from the start of \a line.
+     */
+    cheap_ruler::point along(const cheap_ruler::line_string& line, double dist) const {
+        if (line.empty()) {
+            return {};
+        }
+        if (dist <= 0.0) {
+            return line[0];
+        }
+        double sum = 0.0;
+        for (std::size_t i = 0; i + 1 < line.size(); ++i) {
+            const auto inverse = internal::vincentyInverse(line[i], line[i + 1]);
+            const double d = inverse.distance * unitsPerMetre_;
+            sum += d;
+            if (sum > dist) {
+                return internal::vincentyDirect(line[i], inverse.azimuth, (dist - (sum - d)) / unitsPerMetre_);
+            }
+        }
+        return line.back();
+    }
+
+    /**
+     * @brief The point of \a line closest to \a p.
+     *
+     * The closest point of each segment is found by iterating the spherical along-track
+     * distance on the ellipsoid, which converges in a few steps.
+     *
+     * @return the closest point, the index of its segment and its position along that
+     * segment, from 0 to 1, like \c CheapRuler::pointOnLine
+     */
+    std::tuple<cheap_ruler::point, unsigned, double> pointOnLine(const cheap_ruler::line_string& line,
+                                                                 cheap_ruler::point p) const {
+        if (line.empty()) {
+            return std::make_tuple(cheap_ruler::point(), 0u, 0.0);
+        }
+        if (line.size() == 1) {
+            return std::make_tuple(line[0], 0u, 0.0);
+        }
+
+        double minDist = std::numeric_limits<double>::infinity();
+        cheap_ruler::point minPoint;
+        unsigned minI = 0;
+        double minT = 0.0;
+        for (std::size_t i = 0; i + 1 < line.size(); ++i) {
+            double t = 0.0;
+            const cheap_ruler::point closest = closestOnSegment(line[i], line[i + 1], p, t);
+            const double dist = internal::vincentyInverse(closest, p).distance;
+            if (dist < minDist) {
+                minDist = dist;
+                minPoint = closest;
+                minI = static_cast<unsigned>(i);
+                minT = t;
+            }
+        }
+        return std::make_tuple(minPoint, minI, minT);
+    }
+
+    /**
+     * @brief The part of \a line between the points closest to \a start and \a stop.
+     */
+    cheap_ruler::line_string lineSlice(cheap_ruler::point start,
+                                       cheap_ruler::point stop,
+                                       const cheap_ruler::line_string& line) const {
+        if (line.size() < 2) {
+            return {};
+        }
+        auto p1 = pointOnLine(line, start);
+        auto p2 = pointOnLine(line, stop);
+        if (std::get<1>(p1) > std::get<1>(p2) ||
+            (std::get<1>(p1) == std::get<1>(p2) && std::get<2>(p1) > std::get<2>(p2))) {
+            std::swap(p1, p2);
+        }
+
+        cheap_ruler::line_string slice = {std::get<0>(p1)};
+        const unsigned l = std::get<1>(p1) + 1;
+        const unsigned r = std::get<1>(p2);
+        if (line[l] != slice[0] && l <= r) {
+            slice.push_back(line[l]);
+        }
+        for (unsigned i = l + 1; i <= r; ++i) {
+            slice.push_back(line[i]);
+        }
+        if (line[r] != std::get<0>(p2)) {
+            slice.push_back(std::get<0>(p2));
+        }
+        return slice;
+    }
+
+    /**
+     * @brief The part of \a line between distances \a start and \a stop from its start.
+     */
+    cheap_ruler::line_string lineSliceAlong(double start, double stop, const cheap_ruler::line_string& line) const {
+        cheap_ruler::line_string slice;
+        double sum = 0.0;
+        for (std::size_t i = 0; i + 1 < line.size(); ++i) {
+            const auto inverse = internal::vincentyInverse(line[i], line[i + 1]);
+            const double d = inverse.distance * unitsPerMetre_;
+            sum += d;
+            if (sum > start && slice.empty()) {
+                slice.push_back(internal::vincentyDirect(line[i], inverse.azimuth, (start - sum + d) / unitsPerMetre_));
+            }
+            if (sum >= stop) {
+                slice.push_back(internal::vincentyDirect(line[i], inverse.azimuth, (stop - sum + d) / unitsPerMetre_));
+                return slice;
+            }
+            if (sum > start) {
+                slice.push_back(line[i + 1]);
+            }
+        }
+        return slice;
+    }
+
+    /**
+     * @brief A box containing every point within distance \a buffer of \a p.
+     *
+     * Like \c CheapRuler, longitudes are not wrapped. A buffer that reaches a pole spans
+     * all longitudes.
+     */
+    cheap_ruler::box bufferPoint(cheap_ruler::point p, double buffer) const {
+        return bufferBBox(cheap_ruler::box(p, p), buffer);
+    }
+
+    /**
+     * @brief A box containing every point within distance \a buffer of \a bbox.
+     */
+    cheap_ruler::box bufferBBox(cheap_ruler::box bbox, double buffer) const {
+        const double metres = buffer / unitsPerMetre_;
+        double south = internal::vincentyDirect(bbox.min, M_PI, metres).y;
+        double north = internal::vincentyDirect(bbox.max, 0.0, metres).y;
+        // A geodesic circle is widest at the latitude nearest a pole, which is a corner.
+        const double extent = std::max(longitudeExtent(bbox.min.y, metres), longitudeExtent(bbox.max.y, metres));
+        if (metres >= internal::vincentyInverse(bbox.min, {bbox.min.x, -90.0}).distance) {
+            south = -90.0;
+        }
+        if (metres >= internal::vincentyInverse(bbox.max, {bbox.max.x, 90.0}).distance) {
+            north = 90.0;
+        }
+        return {{bbox.min.x - extent, south}, {bbox.max.x + extent, north}};
+    }
+
+private:
+    // The point of the segment from a to b closest to p, and its position t along it.
+    static cheap_ruler::point closestOnSegment(cheap_ruler::point a,
+                                               cheap_ruler::point b,
+                                               cheap_ruler::point p,
+                                               double& t) {
+        const auto segment = internal::vincentyInverse(a, b);
+        t = 0.0;
+        if (segment.distance == 0.0) {
+            return a;
+        }
+
+        double along = 0.0;
+        double azimuth = segment.azimuth;
+        cheap_ruler::point current = a;
+        for (int iteration = 0; iteration < 50; ++iteration) {
+            const auto toP = internal::vincentyInverse(current, p);
+            const double sigma = toP.distance / internal::kWgs84A;
+            const double step =
+                internal::kWgs84A * std::atan2(std::cos(toP.azimuth - azimuth) * std::sin(sigma), std::cos(sigma));
+            const double next = std::max(0.0, std::min(segment.distance, along + step));
+            const bool done = std::abs(next - along) <= 1e-6;
+            along = next;
+            if (done) {
+                break;
+            }
+            current = internal::vincentyDirect(a, segment.azimuth, along, &azimuth);
+        }
+
+        t = along / segment.distance;
+        if (along == 0.0) {
+            return a;
+        }
+        if (along == segment.distance) {
+            return b;
+        }
+        return internal::vincentyDirect(a, segment.azimuth, along);
+    }
+
+    // Largest longitude difference, in degrees, between a point at the given latitude and
+    // the points at distance metres from it.
+    static double longitudeExtent(double latitude, double metres) {
+        const cheap_ruler::point origin(0.0, latitude);
+        if (metres >= internal::vincentyInverse(origin, {0.0, latitude < 0.0 ? -90.0 : 90.0}).distance) {
+            return 180.0;
+        }
+        // The longitude reached is unimodal in the azimuth, so a golden section search finds
+        // its maximum.
+        auto reach = [&](double azimuth) { return internal::vincentyDirect(origin, azimuth, metres).x; };
+        const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+        double lo = 0.0;
+        double hi = M_PI;
+        double x1 = hi - ratio * (hi - lo);
+        double x2 = lo + ratio * (hi - lo);
+        double f1 = reach(x1);
+        double f2 = reach(x2);
+        for (int iteration = 0; iteration < 60; ++iteration) {
+            if (f1 < f2) {
+                lo = x1;
+                x1 = x2;
+                f1 = f2;
+                x2 = lo + ratio * (hi - lo);
+                f2 = reach(x2);
+            } else {
+                hi = x2;
+                x2 = x1;
+                f2 = f1;
+                x1 = hi - ratio * (hi - lo);
+                f1 = reach(x1);
+            }
+        }
+        return std::min(180.0, std::max(f1, f2));
+    }
+
+    double unitsPerMetre_;
+};
+
+/**
+ * @brief Measures with a \c CheapRuler where it is accurate enough and with a
+ * \c GeodesicRuler elsewhere.
+ *
+ * There is no reference latitude: a distance or bearing between two points uses a
+ * \c CheapRuler at their own mid-latitude, so short segments are cheap anywhere away
+ * from the poles. Each measurement first bounds the relative error left by that
+ * approximation, which comes from the curvature of the parallels and of the earth
+ * across the segment. Only measurements whose bound exceeds \a maxError are solved on
+ * the ellipsoid.
+ *
+ * Bearings and destinations are also off by half the convergence of the meridians
+ * between the points. Their bound adds that angle, in radians, which is the
+ * cross-track error relative to the distance. Methods taking a line or a polygon use
+ * one ruler at the middle of its latitude range, and only if every segment, or the
+ * bounding box for area(), passes the bound for that ruler.
+ *
+ * The methods are those of \c GeodesicRuler.
+ */
+class AutoRuler {
+public:
+    /**
+     * @brief Construct a new \c AutoRuler object.
+     *
+     * @param unit unit of all distances
+     * @param maxError largest accepted relative error of the cheap approximation
+     */
+    explicit AutoRuler(cheap_ruler::CheapRuler::Unit unit = cheap_ruler::CheapRuler::Kilometers,
+                       double maxError = 1e-3)
+        : geodesic_(unit),
+          unit_(unit),
+          unitsPerRadius_(internal::unitsPerKilometre(unit) * internal::kWgs84A / 1000.0),
+          maxError_(maxError) {}
+
+    /**
+     * @brief Upper estimate of the relative error of \c CheapRuler::distance(a, b) at
+     * the mid-latitude of \a a and \a b, given the distance \a dist it returned.
+     */
+    double errorBound(cheap_ruler::point a, cheap_ruler::point b, double dist) const {
+        if (std::abs(a.x - b.x) > 90.0) {
+            return 1.0;
+        }
+        // The multipliers are exact to first order at the mid-latitude φm. What remains is
+        // second order in the latitude span, in the turn of the parallel and in the
+        // curvature of the earth. Against GeodesicRuler the error stays below half of
+        // the sum below.
+        const double midLatitude = (a.y + b.y) / 2.0 * internal::kRadians;
+        const double span = std::abs(a.y - b.y) / 2.0 * internal::kRadians / std::cos(midLatitude);
+        const double turn = std::abs(a.x - b.x) * internal::kRadians * std::sin(std::abs(midLatitude));
+        const double angle = dist / unitsPerRadius_;
+        return kFitError + (span * span + turn * turn + angle * angle) / 6.0;
+    }
+
+    /**
+     * @brief Upper estimate of the error, in radians, of \c CheapRuler::bearing(a, b) at
+     * the mid-latitude of \a a and \a b.
+     */
+    double bearingErrorBound(cheap_ruler::point a, cheap_ruler::point b) const {
+        return errorBound(a, b, rulerAt((a.y + b.y) / 2.0).distance(a, b)) + convergence(a, b);
+    }
+
+    /**
+     * @brief Distance between two points.
+     */
+    double distance(cheap_ruler::point a, cheap_ruler::point b) const {
+        const double dist = rulerAt((a.y + b.y) / 2.0).distance(a, b);
+        return errorBound(a, b, dist) <= maxError_ ? dist : geodesic_.distance(a, b);
+    }
+
+    /**
+     * @brief Bearing from \a a to \a b in degrees, from -180 to 180.
+     */
+    double bearing(cheap_ruler::point a, cheap_ruler::point b) const {
+        return bearingErrorBound(a, b) <= maxError_ ? rulerAt((a.y + b.y) / 2.0).bearing(a, b)
+                                                    : geodesic_.bearing(a, b);
+    }
+
+    /**
+     * @brief The point at distance \a dist and bearing \a bearing from \a origin.
+     */
+    cheap_ruler::point destination(cheap_ruler::point origin, double dist, double bearing) const {
+        // Step once at the origin to find the mid-latitude, then again from there.
+        const auto estimate = rulerAt(origin.y).destination(origin, dist, bearing);
+        const auto cheap = rulerAt((origin.y + estimate.y) / 2.0).destination(origin, dist, bearing);
+        return bearingErrorBound(origin, cheap) <= maxError_ ? cheap : geodesic_.destination(origin, dist, bearing);
+    }
+
+    /**
+     * @brief Total length of a line, choosing the method for each segment.
+     */
+    double lineDistance(const cheap_ruler::line_string& points) const {
+        double total = 0.0;
+        for (std::size_t i = 0; i + 1 < points.size(); ++i) {
+            total += distance(points[i], points[i + 1]);
+        }
+        return total;
+    }
+
+    /**
+     * @brief Area of a polygon, in square units.
+     */
+    double area(const cheap_ruler::polygon& poly) const {
+        if (poly.empty() || poly[0].empty()) {
+            return 0.0;
+        }
+        cheap_ruler::box bounds(poly[0][0], poly[0][0]);
+        for (const auto& p : poly[0]) {
+            bounds.min = {std::min(bounds.min.x, p.x), std::min(bounds.min.y, p.y)};
+            bounds.max = {std::max(bounds.max.x, p.x), std::max(bounds.max.y, p.y)};
+        }
+        const double latitude = (bounds.min.y + bounds.max.y) / 2.0;
+        auto ruler = rulerAt(latitude);
+        // Both multipliers enter the area.
+        const double bound = 2.0 * spanBound(latitude, bounds.min, bounds.max, ruler.distance(bounds.min, bounds.max));
+        return bound <= maxError_ ? ruler.area(poly) : geodesic_.area(poly);
+    }
+
+    /**
+     * @brief The point at distance \a dist from the start of \a line.
+     */
+    cheap_ruler::point along(const cheap_ruler::line_string& line, double dist) const {
+        const double latitude = midLatitude(line);
+        return cheapLine(line, latitude) ? rulerAt(latitude).along(line, dist) : geodesic_.along(line, dist);
+    }
+
+    /**
+     * @brief The point of \a line closest to \a p, like \c CheapRuler::pointOnLine.
+     */
+    std::tuple<cheap_ruler::point, unsigned, double> pointOnLine(const cheap_ruler::line_string& line,
+                                                                 cheap_ruler::point p) const {
+        const double latitude = midLatitude(line, {p});
+        if (cheapLine(line, latitude)) {
+            auto ruler = rulerAt(latitude);
+            auto result = ruler.pointOnLine(line, p);
+            if (cheapOffset(ruler, latitude, p, std::get<0>(result))) {
+                return result;
+            }
+        }
+        return geodesic_.pointOnLine(line, p);
+    }
+
+    /**
+     * @brief The part of \a line between the points closest to \a start and \a stop.
+     */
+    cheap_ruler::line_string lineSlice(cheap_ruler::point start,
+                                       cheap_ruler::point stop,
+                                       const cheap_ruler::line_string& line) const {
+        const double latitude = midLatitude(line, {start, stop});
+        if (line.size() >= 2 && cheapLine(line, latitude)) {
+            auto ruler = rulerAt(latitude);
+            const auto p1 = ruler.pointOnLine(line, start);
+            const auto p2 = ruler.pointOnLine(line, stop);
+            if (cheapOffset(ruler, latitude, start, std::get<0>(p1)) &&
+                cheapOffset(ruler, latitude, stop, std::get<0>(p2))) {
+                return ruler.lineSlice(start, stop, line);
+            }
+        }
+        return geodesic_.lineSlice(start, stop, line);
+    }
+
+    /**
+     * @brief The part of \a line between distances \a start and \a stop from its start.
+     */
+    cheap_ruler::line_string lineSliceAlong(double start, double stop, const cheap_ruler::line_string& line) const {
+        const double latitude = midLatitude(line);
+        return cheapLine(line, latitude) ? rulerAt(latitude).lineSliceAlong(start, stop, line)
+                                         : geodesic_.lineSliceAlong(start, stop, line);
+    }
+
+    /**
+     * @brief A box containing every point within distance \a buffer of \a p.
+     */
+    cheap_ruler::box bufferPoint(cheap_ruler::point p, double buffer) const {
+        return bufferBBox(cheap_ruler::box(p, p), buffer);
+    }
+
+    /**
+     * @brief A box containing every point within distance \a buffer of \a bbox.
+     */
+    cheap_ruler::box bufferBBox(cheap_ruler::box bbox, double buffer) const {
+        const double latitude = (bbox.min.y + bbox.max.y) / 2.0;
+        const auto cheap = rulerAt(latitude).bufferBBox(bbox, buffer);
+        return spanBound(latitude, cheap.min, cheap.max, buffer) <= maxError_ ? cheap
+                                                                               : geodesic_.bufferBBox(bbox, buffer);
+    }
+
+private:
+    // Error of the cosine series of CheapRuler at its own reference latitude.
+    static constexpr double kFitError = 1e-4;
+
+    cheap_ruler::CheapRuler rulerAt(double latitude) const { return cheap_ruler::CheapRuler(latitude, unit_); }
+
+    // Relative error of a distance measured with a ruler at `latitude`, which need not be
+    // the mid-latitude of a and b.
+    double spanBound(double latitude, cheap_ruler::point a, cheap_ruler::point b, double dist) const {
+        if (std::abs(a.x - b.x) > 90.0) {
+            return 1.0;
+        }
+        // The longitude multiplier scales with cos(latitude), and
+        // |cos(φ0 + δ) / cos(φ0) - 1| <= |tan(φ0)| |δ| + δ² / 2. The latitude multiplier
+        // changes by less than 1.1% of δ. Curvature adds about (d / R)² / 6.
+        const double delta = std::max(std::abs(a.y - latitude), std::abs(b.y - latitude)) * internal::kRadians;
+        const double tanLatitude = std::abs(std::tan(latitude * internal::kRadians));
+        const double angle = dist / unitsPerRadius_;
+        return kFitError + (tanLatitude + 0.011) * delta + delta * delta / 2.0 + angle * angle / 6.0;
+    }
+
+    // The initial azimuth of the geodesic differs from the straight line by half the
+    // meridian convergence, Δλ sin(φ) / 2.
+    static double convergence(cheap_ruler::point a, cheap_ruler::point b) {
+        const double sinLatitude = std::sin(std::max(std::abs(a.y), std::abs(b.y)) * internal::kRadians);
+        return std::abs(a.x - b.x) * internal::kRadians * sinLatitude / 2.0;
+    }
+
+    // Middle of the latitude range of line and the extra points.
+    static double midLatitude(const cheap_ruler::line_string& line,
+                              std::initializer_list<cheap_ruler::point> extra = {}) {
+        double minY = std::numeric_limits<double>::infinity();
+        double maxY = -minY;
+        for (const auto& p : line) {
+            minY = std::min(minY, p.y);
+            maxY = std::max(maxY, p.y);
+        }
+        for (const auto& p : extra) {
+            minY = std::min(minY, p.y);
+            maxY = std::max(maxY, p.y);
+        }
+        return minY <= maxY ? (minY + maxY) / 2.0 : 0.0;
+    }
+
+    bool cheapLine(const cheap_ruler::line_string& line, double latitude) const {
+        auto ruler = rulerAt(latitude);
+        for (std::size_t i = 0; i + 1 < line.size(); ++i) {
+            if (spanBound(latitude, line[i], line[i + 1], ruler.distance(line[i], line[i + 1])) > maxError_) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Whether the offset from p to its projection q, measured by ruler, is accurate in
+    // length and direction.
+    bool cheapOffset(cheap_ruler::CheapRuler& ruler,
+                     double latitude,
+                     cheap_ruler::point p,
+                     cheap_ruler::point q) const {
+        return spanBound(latitude, p, q, ruler.distance(p, q)) + convergence(p, q) <= maxError_;
+    }
+
+    GeodesicRuler geodesic_;
+    cheap_ruler::CheapRuler::Unit unit_;
+    double unitsPerRadius_;
+    double maxError_;
+};
+
+} // namespace base
+} // namespace mapbox
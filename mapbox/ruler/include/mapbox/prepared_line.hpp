@@ -0,0 +1,239 @@
+#pragma once
+
+#include <mapbox/batch_ruler.hpp>
+#include <mapbox/cheap_ruler.hpp>
+#include <mapbox/flatbush.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mapbox {
+namespace base {
+
+/**
+ * @brief A line prepared for repeated measurements with a \c CheapRuler.
+ *
+ * Construction computes the distance from the start of the line to each vertex and
+ * indexes the bounding boxes of the segments in a \c Flatbush, scaled by the ruler so
+ * that box distances are distances in ruler units. pointOnLine() then visits only the
+ * segments near the point, and along() and lineSliceAlong() find their first segment by
+ * binary search. Results match the same-named \c CheapRuler members up to rounding.
+ */
+class PreparedLine {
+public:
+    /**
+     * @brief Construct a new \c PreparedLine object.
+     *
+     * @param line the line to prepare
+     * @param ruler the ruler to measure with, usually one for the latitude of the line
+     */
+    PreparedLine(cheap_ruler::line_string line, cheap_ruler::CheapRuler ruler)
+        : line_(std::move(line)), cumulative_(line_.size(), 0.0) {
+        const BatchRuler batch(ruler);
+        kx_ = batch.kx();
+        ky_ = batch.ky();
+        if (line_.size() < 2) {
+            return;
+        }
+
+        std::vector<double> xs;
+        std::vector<double> ys;
+        xs.reserve(line_.size());
+        ys.reserve(line_.size());
+        for (const auto& p : line_) {
+            xs.push_back(p.x);
+            ys.push_back(p.y);
+        }
+        batch.segmentLengths(xs.data(), ys.data(), line_.size(), cumulative_.data() + 1);
+        for (std::size_t i = 1; i < cumulative_.size(); ++i) {
+            cumulative_[i] += cumulative_[i - 1];
+        }
+
+        index_ = std::make_unique<Flatbush<double>>(line_.size() - 1);
+        for (std::size_t i = 0; i + 1 < line_.size(); ++i) {
+            const auto& a = line_[i];
+            const auto& b = line_[i + 1];
+            index_->add(std::min(a.x, b.x) * kx_,
+                        std::min(a.y, b.y) * ky_,
+                        std::max(a.x, b.x) * kx_,
+                        std::max(a.y, b.y) * ky_);
+        }
+        index_->finish();
+    }
+
+    /**
+     * @brief The prepared line.
+     */
+    const cheap_ruler::line_string& line() const { return line_; }
+
+    /**
+     * @brief Total length of the line.
+     */
+    double length() const { return cumulative_.empty() ? 0.0 : cumulative_.back(); }
+
+    /**
+     * @brief Distance from the start of the line to the position \a t along segment
+     * \a index, as returned by pointOnLine().
+     */
+    double distanceAlong(unsigned index, double t) const {
+        if (index + 1 >= cumulative_.size()) {
+            return length();
+        }
+        return cumulative_[index] + (cumulative_[index + 1] - cumulative_[index]) * t;
+    }
+
+    /**
+     * @brief The point of the line closest to \a p.
+     *
+     * @return the closest point, the index of its segment and its position along that
+     * segment, from 0 to 1, like \c CheapRuler::pointOnLine
+     */
+    std::tuple<cheap_ruler::point, unsigned, double> pointOnLine(cheap_ruler::point p) const {
+        if (line_.empty()) {
+            return std::make_tuple(cheap_ruler::point(), 0u, 0.0);
+        }
+        if (!index_) {
+            return std::make_tuple(line_[0], 0u, 0.0);
+        }
+
+        double minDist = std::numeric_limits<double>::infinity();
+        cheap_ruler::point minPoint;
+        unsigned minI = 0;
+        double minT = 0.0;
+
+        index_->visitNeighbors(p.x * kx_, p.y * ky_, [&](std::uint32_t i, double boxDist) {
+            // Box distances are computed in scaled coordinates, so allow for rounding
+            // before giving up on segments that may tie with the best one.
+            if (boxDist > minDist * (1.0 + 1e-9)) {
+                return false;
+            }
+            double t = 0.0;
+            double x = line_[i].x;
+            double y = line_[i].y;
+            double dx = (line_[i + 1].x - x) * kx_;
+            double dy = (line_[i + 1].y - y) * ky_;
+            if (dx != 0.0 || dy != 0.0) {
+                t = ((p.x - x) * kx_ * dx + (p.y - y) * ky_ * dy) / (dx * dx + dy * dy);
+                if (t > 1.0) {
+                    x = line_[i + 1].x;
+                    y = line_[i + 1].y;
+                } else if (t > 0.0) {
+                    x += (dx / kx_) * t;
+                    y += (dy / ky_) * t;
+                }
+            }
+            dx = (p.x - x) * kx_;
+            dy = (p.y - y) * ky_;
+            const double sqDist = dx * dx + dy * dy;
+            // CheapRuler keeps the first of equally close segments.
+            if (sqDist < minDist || (sqDist == minDist && i < minI)) {
+                minDist = sqDist;
+                minPoint = cheap_ruler::point(x, y);
+                minI = i;
+                minT = t;
+            }
+            return true;
+        });
+
+        return std::make_tuple(minPoint, minI, std::max(0.0, std::min(1.0, minT)));
+    }
+
+    /**
+     * @brief The point at distance \a dist from the start of the line.
+     */
+    cheap_ruler::point along(double dist) const {
+        if (line_.empty()) {
+            return {};
+        }
+        if (dist <= 0.0) {
+            return line_[0];
+        }
+        const auto next = std::upper_bound(cumulative_.begin() + 1, cumulative_.end(), dist);
+        if (next == cumulative_.end()) {
+            return line_.back();
+        }
+        const auto i = static_cast<std::size_t>(next - cumulative_.begin()) - 1;
+        return interpolate(i, dist);
+    }
+
+    /**
+     * @brief The part of the line between the points closest to \a start and \a stop.
+     */
+    cheap_ruler::line_string lineSlice(cheap_ruler::point start, cheap_ruler::point stop) const {
+        if (!index_) {
+            return {};
+        }
+        auto p1 = pointOnLine(start);
+        auto p2 = pointOnLine(stop);
+        if (std::get<1>(p1) > std::get<1>(p2) ||
+            (std::get<1>(p1) == std::get<1>(p2) && std::get<2>(p1) > std::get<2>(p2))) {
+            std::swap(p1, p2);
+        }
+
+        cheap_ruler::line_string slice = {std::get<0>(p1)};
+        const unsigned l = std::get<1>(p1) + 1;
+        const unsigned r = std::get<1>(p2);
+        if (line_[l] != slice[0] && l <= r) {
+            slice.push_back(line_[l]);
+        }
+        for (unsigned i = l + 1; i <= r; ++i) {
+            slice.push_back(line_[i]);
+        }
+        if (line_[r] != std::get<0>(p2)) {
+            slice.push_back(std::get<0>(p2));
+        }
+        return slice;
+    }
+
+    /**
+     * @brief The part of the line between distances \a start and \a stop from its start.
+     */
+    cheap_ruler::line_string lineSliceAlong(double start, double stop) const {
+        cheap_ruler::line_string slice;
+        if (!index_) {
+            return slice;
+        }
+
+        // Nothing happens on the segments that end before both start and stop.
+        const auto first = std::upper_bound(cumulative_.begin() + 1, cumulative_.end(), start);
+        const auto last = std::lower_bound(cumulative_.begin() + 1, cumulative_.end(), stop);
+        const auto begin = static_cast<std::size_t>(std::min(first, last) - cumulative_.begin()) - 1;
+
+        for (std::size_t i = begin; i + 1 < line_.size(); ++i) {
+            const double sum = cumulative_[i + 1];
+            if (sum > start && slice.empty()) {
+                slice.push_back(interpolate(i, start));
+            }
+            if (sum >= stop) {
+                slice.push_back(interpolate(i, stop));
+                return slice;
+            }
+            if (sum > start) {
+                slice.push_back(line_[i + 1]);
+            }
+        }
+        return slice;
+    }
+
+private:
+    // The point at distance dist from the start of the line, on segment i.
+    cheap_ruler::point interpolate(std::size_t i, double dist) const {
+        const double d = cumulative_[i + 1] - cumulative_[i];
+        return cheap_ruler::CheapRuler::interpolate(line_[i], line_[i + 1], (dist - cumulative_[i]) / d);
+    }
+
+    cheap_ruler::line_string line_;
+    std::vector<double> cumulative_;
+    double kx_;
+    double ky_;
+    std::unique_ptr<Flatbush<double>> index_;
+};
+
+} // namespace base
+} // namespace mapbox
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <mapbox/cheap_ruler.hpp>
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace mapbox {
+namespace base {
+
+/**
+ * @brief Shared table of \c CheapRuler objects for the rows of a tile pyramid.
+ *
+ * \c CheapRuler::fromTile evaluates a handful of transcendental functions on every call.
+ * This table computes the rulers of all rows of a zoom level the first time that zoom
+ * is used and keeps them for the lifetime of the process, so looking up a ruler is an
+ * array access. The table is read-only once built and safe to use from any thread.
+ *
+ * Zoom levels up to \c kMaxZoom are cached, which takes at most 1 MB for the deepest
+ * one. Deeper zooms fall back to \c CheapRuler::fromTile.
+ */
+class TileRulers {
+public:
+    static constexpr std::uint8_t kMaxZoom = 16;
+
+    /**
+     * @brief The ruler of tile row \a y at zoom \a z, same as `CheapRuler::fromTile(y, z)`.
+     */
+    static cheap_ruler::CheapRuler get(std::uint32_t y, std::uint8_t z) {
+        assert(z < 32 && y < (std::uint32_t(1) << z));
+        if (z > kMaxZoom) {
+            return cheap_ruler::CheapRuler::fromTile(y, z);
+        }
+        return rows(z)[y];
+    }
+
+private:
+    static const std::vector<cheap_ruler::CheapRuler>& rows(std::uint8_t z) {
+        static std::array<std::once_flag, kMaxZoom + 1> built;
+        static std::array<std::vector<cheap_ruler::CheapRuler>, kMaxZoom + 1> tables;
+
+        std::call_once(built[z], [z] {
+            const std::uint32_t count = std::uint32_t(1) << z;
+            auto& table = tables[z];
+            table.reserve(count);
+            for (std::uint32_t y = 0; y < count; ++y) {
+                table.push_back(cheap_ruler::CheapRuler::fromTile(y, z));
+            }
+        });
+        return tables[z];
+    }
+};
+
+} // namespace base
+} // namespace mapbox
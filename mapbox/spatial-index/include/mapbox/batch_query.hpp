@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace mapbox {
+namespace base {
+
+/**
+ * @brief Runs many range and radius queries against a spatial index.
+ *
+ * Queries are reordered along a Morton (Z-order) curve of their centres before they
+ * run, so consecutive queries descend into the same parts of the tree while it is
+ * still in cache. Results are reported to a visitor as `(query, id)` pairs, where
+ * `query` is the position of the query in the input array.
+ *
+ * The ordering buffer is kept between calls, so reusing one \c BatchQuery instance for
+ * batches of similar size does not allocate.
+ *
+ * Works with any index that has KDBush-style `range(minX, minY, maxX, maxY, visitor)`
+ * and `within(x, y, r, visitor)` members, such as \c kdbush::KDBush.
+ *
+ * @tparam TNumber the coordinate type of the queries
+ */
+template <typename TNumber>
+class BatchQuery {
+public:
+    struct Box {
+        TNumber minX;
+        TNumber minY;
+        TNumber maxX;
+        TNumber maxY;
+    };
+
+    struct Circle {
+        TNumber x;
+        TNumber y;
+        TNumber r;
+    };
+
+    /**
+     * @brief Runs a bounding box query for each of \a boxes.
+     *
+     * @param index the index to query
+     * @param boxes pointer to the first query
+     * @param count number of queries
+     * @param visitor called as `visitor(std::size_t query, id)` for every match
+     */
+    template <typename TIndex, typename TVisitor>
+    void range(const TIndex& index, const Box* boxes, std::size_t count, TVisitor&& visitor) {
+        sort(count, [boxes](std::size_t i) {
+            return std::make_pair((boxes[i].minX + boxes[i].maxX) / 2, (boxes[i].minY + boxes[i].maxY) / 2);
+        });
+        for (const auto& entry : order_) {
+            const std::size_t query = entry.second;
+            const Box& box = boxes[query];
+            index.range(box.minX, box.minY, box.maxX, box.maxY, [&](const auto id) { visitor(query, id); });
+        }
+    }
+
+    /**
+     * @brief Runs a radius query for each of \a circles.
+     *
+     * @param index the index to query
+     * @param circles pointer to the first query
+     * @param count number of queries
+     * @param visitor called as `visitor(std::size_t query, id)` for every match
+     */
+    template <typename TIndex, typename TVisitor>
+    void within(const TIndex& index, const Circle* circles, std::size_t count, TVisitor&& visitor) {
+        sort(count, [circles](std::size_t i) { return std::make_pair(circles[i].x, circles[i].y); });
+        for (const auto& entry : order_) {
+            const std::size_t query = entry.second;
+            const Circle& circle = circles[query];
+            index.within(circle.x, circle.y, circle.r, [&](const auto id) { visitor(query, id); });
+        }
+    }
+
+private:
+    template <typename TCentre>
+    void sort(std::size_t count, TCentre centre) {
+        assert(count <= std::numeric_limits<std::uint32_t>::max());
+        order_.clear();
+        if (count == 0) {
+            return;
+        }
+
+        TNumber minX = centre(0).first;
+        TNumber minY = centre(0).second;
+        TNumber maxX = minX;
+        TNumber maxY = minY;
+        for (std::size_t i = 1; i < count; ++i) {
+            const auto c = centre(i);
+            minX = std::min(minX, c.first);
+            minY = std::min(minY, c.second);
+            maxX = std::max(maxX, c.first);
+            maxY = std::max(maxY, c.second);
+        }
+
+        const double width = static_cast<double>(maxX - minX);
+        const double height = static_cast<double>(maxY - minY);
+        const double scaleX = width > 0 ? 65535.0 / width : 0.0;
+        const double scaleY = height > 0 ? 65535.0 / height : 0.0;
+
+        order_.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto c = centre(i);
+            const auto x = static_cast<std::uint32_t>(static_cast<double>(c.first - minX) * scaleX);
+            const auto y = static_cast<std::uint32_t>(static_cast<double>(c.second - minY) * scaleY);
+            order_.emplace_back(interleave(x) | (interleave(y) << 1u), static_cast<std::uint32_t>(i));
+        }
+        std::sort(order_.begin(), order_.end());
+    }
+
+    // Spreads the lower 16 bits of v to the even bit positions.
+    static std::uint32_t interleave(std::uint32_t v) {
+        v &= 0x0000ffffu;
+        v = (v | (v << 8u)) & 0x00ff00ffu;
+        v = (v | (v << 4u)) & 0x0f0f0f0fu;
+        v = (v | (v << 2u)) & 0x33333333u;
+        v = (v | (v << 1u)) & 0x55555555u;
+        return v;
+    }
+
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> order_;
+};
+
+} // namespace base
+} // namespace mapbox
@@ -0,0 +1,445 @@
+#pragma once
+
+#include <kdbush.hpp>
+
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mapbox {
+namespace base {
+
+/**
+ * @brief Point index with insert, update and remove, built from static KDBush levels.
+ *
+ * New points go to a small unsorted buffer. When the buffer fills up, it is merged with
+ * the smaller levels into a new KDBush level. Level \c i holds about
+ * `bufferSize * 2^i` points, so a point is re-indexed O(log n) times over its lifetime
+ * and a query visits at most O(log n) trees plus the buffer. Removed points are masked
+ * out of their level until that level is merged again. A level that has lost half of
+ * its points is rebuilt at the next flush of the buffer or at compact().
+ *
+ * Merges of more than about a thousand points are built on another thread while queries
+ * keep using the levels they replace, and are swapped in by a later flush. A flush that
+ * would carry into a level still being built stops one level short instead, leaving that
+ * level over its size for a while, and while the first level is being built the buffer
+ * grows instead. An update therefore never waits for another thread and costs at most a
+ * small merge on its own.
+ *
+ * The query interface matches \c kdbush::KDBush, except that visitors receive the id
+ * the point was inserted with.
+ *
+ * @tparam TNumber coordinate type
+ * @tparam TId point identifier type, must be hashable
+ */
+template <typename TNumber = double, typename TId = std::uint32_t>
+class DynamicKDBush {
+public:
+    /**
+     * @brief Construct a new, empty \c DynamicKDBush object.
+     *
+     * @param bufferSize number of points kept unindexed before they are merged into a level
+     * @param nodeSize leaf size of the KDBush levels
+     */
+    explicit DynamicKDBush(std::size_t bufferSize = 128, std::uint8_t nodeSize = kdbush::KDBush<Point>::defaultNodeSize)
+        : bufferSize_(bufferSize), nodeSize_(nodeSize) {
+        assert(bufferSize_ > 0u);
+    }
+
+    /**
+     * @brief Adds a point, or moves it if \a id is already in the index.
+     */
+    void insert(TId id, TNumber x, TNumber y) {
+        remove(id);
+        bufferPositions_[id] = static_cast<std::uint32_t>(buffer_.ids.size());
+        buffer_.ids.push_back(id);
+        buffer_.points.emplace_back(x, y);
+        ++size_;
+        if (buffer_.ids.size() >= bufferSize_) {
+            flush();
+        }
+    }
+
+    /**
+     * @brief Removes a point.
+     *
+     * @return true if the point was in the index
+     */
+    bool remove(TId id) {
+        auto it = bufferPositions_.find(id);
+        if (it != bufferPositions_.end()) {
+            const std::uint32_t position = it->second;
+            const std::uint32_t last = static_cast<std::uint32_t>(buffer_.ids.size() - 1);
+            bufferPositions_.erase(it);
+            if (position != last) {
+                buffer_.ids[position] = buffer_.ids[last];
+                buffer_.points[position] = buffer_.points[last];
+                bufferPositions_[buffer_.ids[position]] = position;
+            }
+            buffer_.ids.pop_back();
+            buffer_.points.pop_back();
+            --size_;
+            return true;
+        }
+
+        for (auto& level : levels_) {
+            if (level && level->remove(id)) {
+                --size_;
+                return true;
+            }
+        }
+        for (auto& merge : merges_) {
+            for (auto& source : merge->sources) {
+                if (source->remove(id)) {
+                    std::lock_guard<std::mutex> lock(merge->mutex);
+                    if (merge->result) {
+                        merge->result->remove(id);
+                    } else {
+                        merge->removals.push_back(id);
+                    }
+                    --size_;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Number of points in the index.
+     */
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief Merges all points into a single level, which makes queries cheapest.
+     *
+     * Waits for background merges and takes O(n log n) time on this thread.
+     */
+    void compact() {
+        while (!merges_.empty()) {
+            finish(merges_.size() - 1);
+        }
+
+        std::vector<std::unique_ptr<Level>> sources;
+        if (!buffer_.ids.empty()) {
+            sources.push_back(takeBuffer());
+        }
+        for (auto& level : levels_) {
+            if (level) {
+                sources.push_back(std::move(level));
+            }
+        }
+        std::size_t count = 0;
+        std::vector<std::vector<bool>> removed;
+        for (const auto& source : sources) {
+            count += source->live();
+            removed.push_back(source->removed);
+        }
+        std::size_t target = 0;
+        while ((bufferSize_ << target) < count) {
+            ++target;
+        }
+        place(target, build(sources, removed, nodeSize_));
+    }
+
+    /**
+     * @brief Visits the ids of all points inside the given bounding box.
+     */
+    template <typename TVisitor>
+    void range(TNumber minX, TNumber minY, TNumber maxX, TNumber maxY, const TVisitor& visitor) const {
+        auto visit = [&](const Level& level) {
+            level.index.range(minX, minY, maxX, maxY, [&](std::uint32_t i) {
+                if (!level.removed[i]) {
+                    visitor(level.ids[i]);
+                }
+            });
+        };
+        forEachLevel(visit);
+        for (std::size_t i = 0; i < buffer_.ids.size(); ++i) {
+            const Point& p = buffer_.points[i];
+            if (p.first >= minX && p.first <= maxX && p.second >= minY && p.second <= maxY) {
+                visitor(buffer_.ids[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Visits the ids of all points within radius \a r of the given point.
+     */
+    template <typename TVisitor>
+    void within(TNumber qx, TNumber qy, TNumber r, const TVisitor& visitor) const {
+        auto visit = [&](const Level& level) {
+            level.index.within(qx, qy, r, [&](std::uint32_t i) {
+                if (!level.removed[i]) {
+                    visitor(level.ids[i]);
+                }
+            });
+        };
+        forEachLevel(visit);
+        const TNumber r2 = r * r;
+        for (std::size_t i = 0; i < buffer_.ids.size(); ++i) {
+            const TNumber dx = buffer_.points[i].first - qx;
+            const TNumber dy = buffer_.points[i].second - qy;
+            if (dx * dx + dy * dy <= r2) {
+                visitor(buffer_.ids[i]);
+            }
+        }
+    }
+
+private:
+    using Point = std::pair<TNumber, TNumber>;
+
+    static constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+
+    // Merges of up to this many points run on the updating thread, where they cost less
+    // than starting a thread.
+    static constexpr std::size_t kInlineMerge = 1024;
+
+    struct Entries {
+        std::vector<TId> ids;
+        std::vector<Point> points;
+    };
+
+    // Each level finds its own ids with an open addressing table instead of a map shared
+    // by all levels, so that a merged level is swapped in without touching the locations
+    // of its points.
+    struct Level : Entries {
+        Level(Entries entries, std::uint8_t nodeSize)
+            : Entries(std::move(entries)),
+              index(this->points, nodeSize),
+              removed(this->ids.size(), false) {
+            while ((std::size_t(1) << bits) < this->ids.size() * 2) {
+                ++bits;
+            }
+            slots.assign(std::size_t(1) << bits, std::uint32_t(kNone));
+            const std::size_t mask = slots.size() - 1;
+            for (std::uint32_t i = 0; i < this->ids.size(); ++i) {
+                std::size_t slot = home(this->ids[i]);
+                while (slots[slot] != kNone) {
+                    slot = (slot + 1) & mask;
+                }
+                slots[slot] = i;
+            }
+        }
+
+        std::size_t home(const TId& id) const {
+            return static_cast<std::size_t>((std::uint64_t(std::hash<TId>()(id)) * 0x9E3779B97F4A7C15ull) >>
+                                            (64 - bits));
+        }
+
+        // Masks out the point with this id, if the level holds it.
+        bool remove(const TId& id) {
+            const std::size_t mask = slots.size() - 1;
+            for (std::size_t slot = home(id); slots[slot] != kNone; slot = (slot + 1) & mask) {
+                const std::uint32_t i = slots[slot];
+                if (this->ids[i] == id && !removed[i]) {
+                    removed[i] = true;
+                    ++removedCount;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        std::size_t live() const { return this->ids.size() - removedCount; }
+
+        kdbush::KDBush<Point, std::uint32_t> index;
+        std::vector<bool> removed;
+        std::size_t removedCount = 0;
+        std::vector<std::uint32_t> slots;
+        unsigned bits = 1;
+    };
+
+    // A level being built on another thread. Its sources stay in use until it is swapped
+    // in, and points removed from them meanwhile are removed from the result as well.
+    struct Merge {
+        std::size_t target = 0;
+        std::vector<std::unique_ptr<Level>> sources;
+        std::vector<std::vector<bool>> removed;
+        std::mutex mutex;
+        std::vector<TId> removals;
+        std::unique_ptr<Level> result;
+        // Declared last, so that destroying a merge first waits for its thread.
+        std::future<void> built;
+    };
+
+    template <typename TVisitor>
+    void forEachLevel(const TVisitor& visitor) const {
+        for (const auto& level : levels_) {
+            if (level) {
+                visitor(*level);
+            }
+        }
+        for (const auto& merge : merges_) {
+            for (const auto& source : merge->sources) {
+                visitor(*source);
+            }
+        }
+    }
+
+    // The live points of the sources, given their removed flags, in one new level.
+    static std::unique_ptr<Level> build(const std::vector<std::unique_ptr<Level>>& sources,
+                                        const std::vector<std::vector<bool>>& removed,
+                                        std::uint8_t nodeSize) {
+        Entries entries;
+        for (std::size_t s = 0; s < sources.size(); ++s) {
+            for (std::size_t i = 0; i < sources[s]->ids.size(); ++i) {
+                if (!removed[s][i]) {
+                    entries.ids.push_back(sources[s]->ids[i]);
+                    entries.points.push_back(sources[s]->points[i]);
+                }
+            }
+        }
+        if (entries.ids.empty()) {
+            return nullptr;
+        }
+        return std::make_unique<Level>(std::move(entries), nodeSize);
+    }
+
+    std::unique_ptr<Level> takeBuffer() {
+        auto level = std::make_unique<Level>(std::move(buffer_), nodeSize_);
+        buffer_ = Entries();
+        bufferPositions_.clear();
+        return level;
+    }
+
+    void place(std::size_t target, std::unique_ptr<Level> level) {
+        if (!level) {
+            return;
+        }
+        if (levels_.size() <= target) {
+            levels_.resize(target + 1);
+        }
+        assert(!levels_[target]);
+        levels_[target] = std::move(level);
+    }
+
+    // Index of the unfinished merge into `target`, or merges_.size() if there is none.
+    std::size_t pendingAt(std::size_t target) const {
+        std::size_t i = 0;
+        while (i < merges_.size() && merges_[i]->target != target) {
+            ++i;
+        }
+        return i;
+    }
+
+    // Swaps a background merge in, waiting for it if needed.
+    void finish(std::size_t i) {
+        Merge& merge = *merges_[i];
+        merge.built.get();
+        place(merge.target, std::move(merge.result));
+        merges_.erase(merges_.begin() + static_cast<std::ptrdiff_t>(i));
+    }
+
+    // Replaces the sources with one level at `target`, on this thread if they are small.
+    void merge(std::size_t target, std::vector<std::unique_ptr<Level>> sources) {
+        if (sources.size() == 1 && sources[0]->removedCount == 0) {
+            place(target, std::move(sources[0]));
+            return;
+        }
+        std::size_t count = 0;
+        std::vector<std::vector<bool>> removed;
+        for (const auto& source : sources) {
+            count += source->ids.size();
+            removed.push_back(source->removed);
+        }
+        if (count <= kInlineMerge) {
+            place(target, build(sources, removed, nodeSize_));
+            return;
+        }
+
+        auto pending = std::make_unique<Merge>();
+        pending->target = target;
+        pending->sources = std::move(sources);
+        pending->removed = std::move(removed);
+        Merge* raw = pending.get();
+        const std::uint8_t nodeSize = nodeSize_;
+        raw->built = std::async(std::launch::async, [raw, nodeSize] {
+            auto level = build(raw->sources, raw->removed, nodeSize);
+            // Replays removals outside the lock, so that remove() is never held up for long.
+            std::vector<TId> removals;
+            for (;;) {
+                {
+                    std::lock_guard<std::mutex> lock(raw->mutex);
+                    removals.swap(raw->removals);
+                    if (removals.empty()) {
+                        raw->result = std::move(level);
+                        return;
+                    }
+                }
+                for (const TId& id : removals) {
+                    if (level) {
+                        level->remove(id);
+                    }
+                }
+                removals.clear();
+            }
+        });
+        merges_.push_back(std::move(pending));
+    }
+
+    // Swaps finished merges in and merges the buffer with the occupied levels below the
+    // first free level that can hold the result, like carrying in a binary counter. Then
+    // starts the rebuild of a level that has lost half of its points.
+    void flush() {
+        for (std::size_t i = merges_.size(); i-- > 0;) {
+            if (merges_[i]->built.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                finish(i);
+            }
+        }
+
+        if (pendingAt(0) < merges_.size()) {
+            // The first level is still being built, so keep buffering until it is done.
+            return;
+        }
+
+        std::vector<std::unique_ptr<Level>> sources;
+        sources.push_back(takeBuffer());
+        std::size_t count = sources[0]->live();
+        std::size_t target = 0;
+        for (;; ++target) {
+            if (pendingAt(target) < merges_.size()) {
+                // Rather than wait, leave the level below over its size until the merge
+                // into this one is swapped in.
+                --target;
+                break;
+            }
+            if (target < levels_.size() && levels_[target]) {
+                count += levels_[target]->live();
+                sources.push_back(std::move(levels_[target]));
+            } else if (count <= (bufferSize_ << target)) {
+                break;
+            }
+        }
+        merge(target, std::move(sources));
+
+        for (std::size_t i = 0; i < levels_.size(); ++i) {
+            if (levels_[i] && levels_[i]->removedCount * 2 >= levels_[i]->ids.size()) {
+                std::vector<std::unique_ptr<Level>> stale;
+                stale.push_back(std::move(levels_[i]));
+                merge(i, std::move(stale));
+                break;
+            }
+        }
+    }
+
+    const std::size_t bufferSize_;
+    const std::uint8_t nodeSize_;
+    std::size_t size_ = 0;
+    Entries buffer_;
+    std::unordered_map<TId, std::uint32_t> bufferPositions_;
+    std::vector<std::unique_ptr<Level>> levels_;
+    std::vector<std::unique_ptr<Merge>> merges_;
+};
+
+} // namespace base
+} // namespace mapbox
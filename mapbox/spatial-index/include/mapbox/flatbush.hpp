@@ -0,0 +1,614 @@
+#pragma once
+
+#include <nonstd/expected.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mapbox {
+namespace base {
+
+/// @cond internal
+namespace internal {
+
+template <typename T>
+struct FlatbushType;
+template <>
+struct FlatbushType<std::int16_t> : std::integral_constant<std::uint8_t, 3> {};
+template <>
+struct FlatbushType<std::uint16_t> : std::integral_constant<std::uint8_t, 4> {};
+template <>
+struct FlatbushType<std::int32_t> : std::integral_constant<std::uint8_t, 5> {};
+template <>
+struct FlatbushType<std::uint32_t> : std::integral_constant<std::uint8_t, 6> {};
+template <>
+struct FlatbushType<float> : std::integral_constant<std::uint8_t, 7> {};
+template <>
+struct FlatbushType<double> : std::integral_constant<std::uint8_t, 8> {};
+
+// Splits [0, count) into contiguous chunks and runs them on up to `threads` threads.
+template <typename TFunction>
+void parallelFor(std::size_t count, unsigned threads, const TFunction& function) {
+    const std::size_t chunks = std::max<std::size_t>(1u, std::min<std::size_t>(threads, count / 4096u));
+    if (chunks == 1u) {
+        function(std::size_t(0), count);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(chunks - 1);
+    for (std::size_t i = 1; i < chunks; ++i) {
+        workers.emplace_back(function, count * i / chunks, count * (i + 1) / chunks);
+    }
+    function(std::size_t(0), count / chunks);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Sorts chunks on separate threads, then merges neighbouring runs pairwise.
+inline void parallelSort(std::vector<std::uint64_t>& keys, unsigned threads) {
+    const std::size_t chunks = std::max<std::size_t>(1u, std::min<std::size_t>(threads, keys.size() / 65536u));
+    if (chunks == 1u) {
+        std::sort(keys.begin(), keys.end());
+        return;
+    }
+
+    std::vector<std::size_t> bounds;
+    for (std::size_t i = 0; i <= chunks; ++i) {
+        bounds.push_back(keys.size() * i / chunks);
+    }
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < chunks; ++i) {
+        workers.emplace_back(
+            [&keys, &bounds, i] { std::sort(keys.begin() + bounds[i], keys.begin() + bounds[i + 1]); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (std::size_t width = 1; width < chunks; width *= 2) {
+        workers.clear();
+        for (std::size_t i = 0; i + width < chunks; i += 2 * width) {
+            const auto first = keys.begin() + bounds[i];
+            const auto middle = keys.begin() + bounds[i + width];
+            const auto last = keys.begin() + bounds[std::min(i + 2 * width, chunks)];
+            workers.emplace_back([=] { std::inplace_merge(first, middle, last); });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+}
+
+// Position of (x, y) on a Hilbert curve filling a 65536 x 65536 grid.
+// Based on "Fast Hilbert curve generation, sorting, and range queries" by rawrunprotected.
+inline std::uint32_t hilbert(std::uint32_t x, std::uint32_t y) {
+    std::uint32_t a = x ^ y;
+    std::uint32_t b = 0xffffu ^ a;
+    std::uint32_t c = 0xffffu ^ (x | y);
+    std::uint32_t d = x & (y ^ 0xffffu);
+
+    std::uint32_t A = a | (b >> 1u);
+    std::uint32_t B = (a >> 1u) ^ a;
+    std::uint32_t C = ((c >> 1u) ^ (b & (d >> 1u))) ^ c;
+    std::uint32_t D = ((a & (c >> 1u)) ^ (d >> 1u)) ^ d;
+
+    a = A;
+    b = B;
+    c = C;
+    d = D;
+    A = (a & (a >> 2u)) ^ (b & (b >> 2u));
+    B = (a & (b >> 2u)) ^ (b & ((a ^ b) >> 2u));
+    C ^= (a & (c >> 2u)) ^ (b & (d >> 2u));
+    D ^= (b & (c >> 2u)) ^ ((a ^ b) & (d >> 2u));
+
+    a = A;
+    b = B;
+    c = C;
+    d = D;
+    A = (a & (a >> 4u)) ^ (b & (b >> 4u));
+    B = (a & (b >> 4u)) ^ (b & ((a ^ b) >> 4u));
+    C ^= (a & (c >> 4u)) ^ (b & (d >> 4u));
+    D ^= (b & (c >> 4u)) ^ ((a ^ b) & (d >> 4u));
+
+    a = A;
+    b = B;
+    c = C;
+    d = D;
+    C ^= (a & (c >> 8u)) ^ (b & (d >> 8u));
+    D ^= (b & (c >> 8u)) ^ ((a ^ b) & (d >> 8u));
+
+    a = C ^ (C >> 1u);
+    b = D ^ (D >> 1u);
+
+    std::uint32_t i0 = x ^ y;
+    std::uint32_t i1 = b | (0xffffu ^ (i0 | a));
+
+    i0 = (i0 | (i0 << 8u)) & 0x00ff00ffu;
+    i0 = (i0 | (i0 << 4u)) & 0x0f0f0f0fu;
+    i0 = (i0 | (i0 << 2u)) & 0x33333333u;
+    i0 = (i0 | (i0 << 1u)) & 0x55555555u;
+
+    i1 = (i1 | (i1 << 8u)) & 0x00ff00ffu;
+    i1 = (i1 | (i1 << 4u)) & 0x0f0f0f0fu;
+    i1 = (i1 | (i1 << 2u)) & 0x33333333u;
+    i1 = (i1 | (i1 << 1u)) & 0x55555555u;
+
+    return (i1 << 1u) | i0;
+}
+
+} // namespace internal
+/// @endcond
+
+/**
+ * @brief Static packed Hilbert R-tree over bounding boxes.
+ *
+ * Items are added with add() and the tree is built once with finish(). Items are sorted
+ * along a Hilbert curve of their centres and packed into nodes of \c nodeSize
+ * children, so the whole tree lives in a single flat buffer with no pointers.
+ *
+ * The buffer is returned by data() and can be written to disk as is. view() opens
+ * such a buffer, e.g. a memory-mapped file, for querying without copying it.
+ *
+ * Queries report the position at which an item was added. An index of zero items is
+ * valid and finds nothing.
+ *
+ * @tparam TNumber coordinate type
+ */
+template <typename TNumber = double>
+class Flatbush {
+public:
+    static constexpr std::uint16_t kDefaultNodeSize = 16;
+
+    /**
+     * @brief Construct a new \c Flatbush object for \a numItems items.
+     *
+     * @param numItems exact number of items that will be added, may be 0
+     * @param nodeSize maximum number of children per node, at least 2
+     */
+    explicit Flatbush(std::size_t numItems, std::uint16_t nodeSize = kDefaultNodeSize) {
+        init(numItems, std::max<std::uint16_t>(nodeSize, 2u));
+        storage_.resize(byteSize_);
+        data_ = storage_.data();
+        writeHeader();
+        setPointers();
+    }
+
+    Flatbush(Flatbush&&) noexcept = default;
+    Flatbush& operator=(Flatbush&&) noexcept = default;
+    Flatbush(const Flatbush&) = delete;
+    Flatbush& operator=(const Flatbush&) = delete;
+
+    /**
+     * @brief Opens a serialized index without copying it.
+     *
+     * \a data must stay valid and unchanged for the lifetime of the returned index and
+     * must be aligned for \c TNumber, which memory-mapped files always are.
+     *
+     * Besides the header and size, every node is checked once to point at the children
+     * that finish() gives it, and every item position to be below size(). Queries on a
+     * corrupt or truncated buffer therefore never read outside of it. Box coordinates are
+     * not checked, so a corrupt buffer that passes can still return wrong results.
+     *
+     * @return the index, or an error if \a data does not hold a valid index of this type
+     */
+    static nonstd::expected<Flatbush, std::string> view(const std::uint8_t* data, std::size_t size) {
+        if (size < kHeaderSize || data[0] != kMagic) {
+            return nonstd::make_unexpected(std::string("Data is not a Flatbush index"));
+        }
+        if ((data[1] >> 4u) != kVersion) {
+            return nonstd::make_unexpected(std::string("Unsupported Flatbush version"));
+        }
+        if ((data[1] & 0x0fu) != internal::FlatbushType<TNumber>::value) {
+            return nonstd::make_unexpected(std::string("Flatbush coordinate type mismatch"));
+        }
+        if (reinterpret_cast<std::uintptr_t>(data) % alignof(TNumber) != 0) {
+            return nonstd::make_unexpected(std::string("Flatbush data is not aligned"));
+        }
+
+        std::uint16_t nodeSize;
+        std::uint32_t numItems;
+        std::memcpy(&nodeSize, data + 2, sizeof(nodeSize));
+        std::memcpy(&numItems, data + 4, sizeof(numItems));
+        if (nodeSize < 2u) {
+            return nonstd::make_unexpected(std::string("Data is not a Flatbush index"));
+        }
+        if (countNodes(numItems, nodeSize) * 4 > std::numeric_limits<std::uint32_t>::max()) {
+            return nonstd::make_unexpected(std::string("Flatbush data size mismatch"));
+        }
+
+        Flatbush index;
+        index.init(numItems, nodeSize);
+        if (index.byteSize_ != size) {
+            return nonstd::make_unexpected(std::string("Flatbush data size mismatch"));
+        }
+        index.data_ = data;
+        index.setPointers();
+        index.pos_ = index.numNodes_ * 4;
+        if (!index.validNodes()) {
+            return nonstd::make_unexpected(std::string("Flatbush data is corrupt"));
+        }
+
+        nonstd::expected<Flatbush, std::string> result(std::move(index));
+        return result;
+    }
+
+    /**
+     * @brief Adds an item and returns its position.
+     */
+    std::uint32_t add(TNumber minX, TNumber minY, TNumber maxX, TNumber maxY) {
+        assert(!storage_.empty());
+        assert(pos_ < numItems_ * 4);
+        const auto index = static_cast<std::uint32_t>(pos_ >> 2u);
+        indices_[index] = index;
+        boxes_[pos_++] = minX;
+        boxes_[pos_++] = minY;
+        boxes_[pos_++] = maxX;
+        boxes_[pos_++] = maxY;
+        minX_ = std::min(minX_, minX);
+        minY_ = std::min(minY_, minY);
+        maxX_ = std::max(maxX_, maxX);
+        maxY_ = std::max(maxY_, maxY);
+        return index;
+    }
+
+    /**
+     * @brief Adds an item from a box type with `min` and `max` corners, such as
+     * \c mapbox::geometry::box.
+     */
+    template <typename TBox>
+    std::uint32_t add(const TBox& box) {
+        return add(box.min.x, box.min.y, box.max.x, box.max.y);
+    }
+
+    /**
+     * @brief Sorts the items and builds the tree. Must be called once, after all items
+     * were added.
+     *
+     * The resulting index does not depend on the number of threads.
+     *
+     * @param threads number of threads to use, 0 for one per hardware thread
+     */
+    void finish(unsigned threads = 1) {
+        assert(pos_ == numItems_ * 4);
+        if (numItems_ == 0) {
+            return;
+        }
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        if (numItems_ <= nodeSize_) {
+            indices_[pos_ >> 2u] = 0;
+            boxes_[pos_++] = minX_;
+            boxes_[pos_++] = minY_;
+            boxes_[pos_++] = maxX_;
+            boxes_[pos_++] = maxY_;
+            return;
+        }
+
+        sortItems(threads);
+
+        // Parents of level i are stored from levelBounds_[i] onwards, in child order.
+        std::size_t begin = 0;
+        for (std::size_t level = 0; level + 1 < levelBounds_.size(); ++level) {
+            const std::size_t end = levelBounds_[level];
+            const std::size_t parents = (end - begin) / 4 / nodeSize_ + (((end - begin) / 4) % nodeSize_ != 0 ? 1 : 0);
+            internal::parallelFor(parents, threads, [&](std::size_t first, std::size_t last) {
+                for (std::size_t parent = first; parent < last; ++parent) {
+                    const std::size_t child = begin + parent * nodeSize_ * 4;
+                    const std::size_t childEnd = std::min(child + nodeSize_ * 4, end);
+                    TNumber nodeMinX = boxes_[child];
+                    TNumber nodeMinY = boxes_[child + 1];
+                    TNumber nodeMaxX = boxes_[child + 2];
+                    TNumber nodeMaxY = boxes_[child + 3];
+                    for (std::size_t pos = child + 4; pos < childEnd; pos += 4) {
+                        nodeMinX = std::min(nodeMinX, boxes_[pos]);
+                        nodeMinY = std::min(nodeMinY, boxes_[pos + 1]);
+                        nodeMaxX = std::max(nodeMaxX, boxes_[pos + 2]);
+                        nodeMaxY = std::max(nodeMaxY, boxes_[pos + 3]);
+                    }
+                    const std::size_t out = end + parent * 4;
+                    indices_[out >> 2u] = static_cast<std::uint32_t>(child);
+                    boxes_[out] = nodeMinX;
+                    boxes_[out + 1] = nodeMinY;
+                    boxes_[out + 2] = nodeMaxX;
+                    boxes_[out + 3] = nodeMaxY;
+                }
+            });
+            begin = end;
+        }
+        pos_ = numNodes_ * 4;
+    }
+
+    /**
+     * @brief Visits the positions of all items intersecting the given box.
+     *
+     * \a stack is used for the traversal and can be reused between queries to avoid
+     * allocations.
+     */
+    template <typename TVisitor>
+    void range(TNumber minX,
+               TNumber minY,
+               TNumber maxX,
+               TNumber maxY,
+               const TVisitor& visitor,
+               std::vector<std::uint32_t>& stack) const {
+        assert(pos_ == numNodes_ * 4);
+        stack.clear();
+        if (numItems_ == 0) {
+            return;
+        }
+        std::size_t nodeIndex = numNodes_ * 4 - 4;
+
+        while (true) {
+            const std::size_t end = std::min(nodeIndex + nodeSize_ * 4, upperBound(nodeIndex));
+            const bool leaves = nodeIndex < numItems_ * 4;
+            for (std::size_t pos = nodeIndex; pos < end; pos += 4) {
+                if (maxX < boxes_[pos] || maxY < boxes_[pos + 1] || minX > boxes_[pos + 2] ||
+                    minY > boxes_[pos + 3]) {
+                    continue;
+                }
+                if (leaves) {
+                    visitor(indices_[pos >> 2u]);
+                } else {
+                    stack.push_back(indices_[pos >> 2u]);
+                }
+            }
+            if (stack.empty()) {
+                break;
+            }
+            nodeIndex = stack.back();
+            stack.pop_back();
+        }
+    }
+
+    /**
+     * @brief Visits the positions of all items intersecting the given box.
+     */
+    template <typename TVisitor>
+    void range(TNumber minX, TNumber minY, TNumber maxX, TNumber maxY, const TVisitor& visitor) const {
+        std::vector<std::uint32_t> stack;
+        range(minX, minY, maxX, maxY, visitor, stack);
+    }
+
+    /**
+     * @brief Visits items in order of increasing distance from (\a x, \a y).
+     *
+     * The distance of an item is the distance to the nearest point of its box, zero if
+     * the box contains the point. \a visitor is called as
+     * `bool visitor(std::uint32_t position, double squaredDistance)` and stops the search
+     * by returning false.
+     */
+    template <typename TVisitor>
+    void visitNeighbors(TNumber x, TNumber y, TVisitor&& visitor) const {
+        assert(pos_ == numNodes_ * 4);
+        if (numItems_ == 0) {
+            return;
+        }
+        // Entries are (squared distance, position << 1 | isItem).
+        using Entry = std::pair<double, std::uint64_t>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+        std::size_t nodeIndex = numNodes_ * 4 - 4;
+
+        while (true) {
+            const std::size_t end = std::min(nodeIndex + nodeSize_ * 4, upperBound(nodeIndex));
+            const std::uint64_t isItem = nodeIndex < numItems_ * 4 ? 1u : 0u;
+            for (std::size_t pos = nodeIndex; pos < end; pos += 4) {
+                const double dx = axisDistance(x, boxes_[pos], boxes_[pos + 2]);
+                const double dy = axisDistance(y, boxes_[pos + 1], boxes_[pos + 3]);
+                queue.emplace(dx * dx + dy * dy, (std::uint64_t(indices_[pos >> 2u]) << 1u) | isItem);
+            }
+
+            while (!queue.empty() && (queue.top().second & 1u)) {
+                const Entry item = queue.top();
+                queue.pop();
+                if (!visitor(static_cast<std::uint32_t>(item.second >> 1u), item.first)) {
+                    return;
+                }
+            }
+            if (queue.empty()) {
+                return;
+            }
+            nodeIndex = static_cast<std::size_t>(queue.top().second >> 1u);
+            queue.pop();
+        }
+    }
+
+    /**
+     * @brief Returns the positions of up to \a maxResults items nearest to (\a x, \a y)
+     * and no further than \a maxDistance, nearest first.
+     */
+    std::vector<std::uint32_t> neighbors(TNumber x,
+                                         TNumber y,
+                                         std::size_t maxResults,
+                                         double maxDistance = std::numeric_limits<double>::infinity()) const {
+        std::vector<std::uint32_t> result;
+        const double maxDistanceSquared = maxDistance * maxDistance;
+        visitNeighbors(x, y, [&](std::uint32_t position, double distanceSquared) {
+            if (distanceSquared > maxDistanceSquared || result.size() >= maxResults) {
+                return false;
+            }
+            result.push_back(position);
+            return result.size() < maxResults;
+        });
+        return result;
+    }
+
+    /**
+     * @brief Number of items in the index.
+     */
+    std::size_t size() const { return numItems_; }
+
+    /**
+     * @brief Serialized index, valid after finish().
+     */
+    const std::uint8_t* data() const { return data_; }
+
+    /**
+     * @brief Size of the serialized index in bytes.
+     */
+    std::size_t byteSize() const { return byteSize_; }
+
+private:
+    static constexpr std::uint8_t kMagic = 0xfb;
+    static constexpr std::uint8_t kVersion = 1;
+    static constexpr std::size_t kHeaderSize = 8;
+
+    Flatbush() = default;
+
+    void init(std::size_t numItems, std::uint16_t nodeSize) {
+        assert(nodeSize >= 2u);
+        numItems_ = numItems;
+        nodeSize_ = nodeSize;
+        if (numItems == 0) {
+            // No nodes at all, only the header.
+            numNodes_ = 0;
+            levelBounds_.clear();
+            byteSize_ = kHeaderSize;
+            return;
+        }
+
+        std::size_t n = numItems;
+        numNodes_ = n;
+        levelBounds_ = {n * 4};
+        do {
+            n = (n + nodeSize - 1) / nodeSize;
+            numNodes_ += n;
+            levelBounds_.push_back(numNodes_ * 4);
+        } while (n != 1);
+        assert(numNodes_ * 4 <= std::numeric_limits<std::uint32_t>::max());
+
+        byteSize_ = kHeaderSize + numNodes_ * 4 * sizeof(TNumber) + numNodes_ * sizeof(std::uint32_t);
+    }
+
+    // Number of nodes, items included, of a tree over numItems items.
+    static std::size_t countNodes(std::size_t numItems, std::uint16_t nodeSize) {
+        if (numItems == 0) {
+            return 0;
+        }
+        std::size_t n = numItems;
+        std::size_t count = n;
+        do {
+            n = (n + nodeSize - 1) / nodeSize;
+            count += n;
+        } while (n != 1);
+        return count;
+    }
+
+    // Whether every node points at the children finish() gives it and every item position
+    // is below numItems_, so that queries stay inside the buffer.
+    bool validNodes() const {
+        for (std::size_t i = 0; i < numItems_; ++i) {
+            if (indices_[i] >= numItems_) {
+                return false;
+            }
+        }
+        std::size_t begin = 0;
+        for (std::size_t level = 0; level + 1 < levelBounds_.size(); ++level) {
+            const std::size_t end = levelBounds_[level];
+            std::size_t child = begin;
+            for (std::size_t pos = end; pos < levelBounds_[level + 1]; pos += 4, child += nodeSize_ * 4) {
+                if (indices_[pos >> 2u] != child) {
+                    return false;
+                }
+            }
+            begin = end;
+        }
+        return true;
+    }
+
+    void writeHeader() {
+        const auto numItems = static_cast<std::uint32_t>(numItems_);
+        storage_[0] = kMagic;
+        storage_[1] = static_cast<std::uint8_t>((kVersion << 4u) | internal::FlatbushType<TNumber>::value);
+        std::memcpy(&storage_[2], &nodeSize_, sizeof(nodeSize_));
+        std::memcpy(&storage_[4], &numItems, sizeof(numItems));
+    }
+
+    void setPointers() {
+        // Views only read through these pointers.
+        auto* data = const_cast<std::uint8_t*>(data_);
+        boxes_ = reinterpret_cast<TNumber*>(data + kHeaderSize);
+        indices_ = reinterpret_cast<std::uint32_t*>(data + kHeaderSize + numNodes_ * 4 * sizeof(TNumber));
+    }
+
+    void sortItems(unsigned threads) {
+        const double width = static_cast<double>(maxX_) - static_cast<double>(minX_);
+        const double height = static_cast<double>(maxY_) - static_cast<double>(minY_);
+        const double scaleX = width > 0 ? 65535.0 / width : 0.0;
+        const double scaleY = height > 0 ? 65535.0 / height : 0.0;
+
+        // Sorting by (hilbert value, position) gives the same order for any thread count.
+        std::vector<std::uint64_t> keys(numItems_);
+        internal::parallelFor(numItems_, threads, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                const TNumber* box = boxes_ + i * 4;
+                const double x = (static_cast<double>(box[0]) + box[2]) / 2 - minX_;
+                const double y = (static_cast<double>(box[1]) + box[3]) / 2 - minY_;
+                const auto value = internal::hilbert(static_cast<std::uint32_t>(x * scaleX),
+                                                     static_cast<std::uint32_t>(y * scaleY));
+                keys[i] = (std::uint64_t(value) << 32u) | i;
+            }
+        });
+        internal::parallelSort(keys, threads);
+
+        std::vector<TNumber> boxes(boxes_, boxes_ + numItems_ * 4);
+        internal::parallelFor(numItems_, threads, [&](std::size_t first, std::size_t last) {
+            for (std::size_t i = first; i < last; ++i) {
+                const auto from = static_cast<std::uint32_t>(keys[i]);
+                std::copy_n(&boxes[from * std::size_t(4)], 4, boxes_ + i * 4);
+                indices_[i] = from;
+            }
+        });
+    }
+
+    std::size_t upperBound(std::size_t value) const {
+        return *std::upper_bound(levelBounds_.begin(), levelBounds_.end(), value);
+    }
+
+    static double axisDistance(TNumber k, TNumber min, TNumber max) {
+        return k < min ? static_cast<double>(min) - k : k <= max ? 0.0 : static_cast<double>(k) - max;
+    }
+
+    std::vector<std::uint8_t> storage_;
+    const std::uint8_t* data_ = nullptr;
+    std::size_t byteSize_ = 0;
+    TNumber* boxes_ = nullptr;
+    std::uint32_t* indices_ = nullptr;
+
+    std::size_t numItems_ = 0;
+    std::size_t numNodes_ = 0;
+    std::uint16_t nodeSize_ = kDefaultNodeSize;
+    std::vector<std::size_t> levelBounds_;
+    std::size_t pos_ = 0;
+
+    TNumber minX_ = std::numeric_limits<TNumber>::max();
+    TNumber minY_ = std::numeric_limits<TNumber>::max();
+    TNumber maxX_ = std::numeric_limits<TNumber>::lowest();
+    TNumber maxY_ = std::numeric_limits<TNumber>::lowest();
+};
+
+template <typename TNumber>
+constexpr std::uint16_t Flatbush<TNumber>::kDefaultNodeSize;
+template <typename TNumber>
+constexpr std::uint8_t Flatbush<TNumber>::kMagic;
+template <typename TNumber>
+constexpr std::uint8_t Flatbush<TNumber>::kVersion;
+template <typename TNumber>
+constexpr std::size_t Flatbush<TNumber>::kHeaderSize;
+
+} // namespace base
+} // namespace mapbox
@@ -0,0 +1,125 @@
+#include <mapbox/cluster_tile.hpp>
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+using mapbox::feature::feature;
+using mapbox::feature::feature_collection;
+using mapbox::feature::property_map;
+using mapbox::geometry::point;
+
+// Decodes the top level fields of a protobuf message, keyed by field number.
+std::multimap<std::uint32_t, std::string> readMessage(const std::string& data) {
+    std::multimap<std::uint32_t, std::string> fields;
+    std::size_t pos = 0;
+    auto varint = [&] {
+        std::uint64_t value = 0;
+        for (unsigned shift = 0;; shift += 7) {
+            const auto byte = static_cast<std::uint8_t>(data[pos++]);
+            value |= std::uint64_t(byte & 0x7fu) << shift;
+            if (byte < 0x80u) {
+                return value;
+            }
+        }
+    };
+    while (pos < data.size()) {
+        const std::uint64_t tag = varint();
+        const auto field = static_cast<std::uint32_t>(tag >> 3u);
+        switch (tag & 0x7u) {
+            case 0:
+                fields.emplace(field, std::to_string(varint()));
+                break;
+            case 1:
+                fields.emplace(field, data.substr(pos, 8));
+                pos += 8;
+                break;
+            case 2: {
+                const auto size = static_cast<std::size_t>(varint());
+                fields.emplace(field, data.substr(pos, size));
+                pos += size;
+                break;
+            }
+            default:
+                assert(false);
+        }
+    }
+    return fields;
+}
+
+void testEncodeEmpty() {
+    assert(mapbox::base::encodeClusterTile({}).empty());
+}
+
+void testEncode() {
+    feature_collection<std::int16_t> tile;
+    tile.emplace_back(point<std::int16_t>(10, -3),
+                      property_map{{"cluster", true}, {"point_count", std::uint64_t(42)}, {"name", std::string("a")}},
+                      std::uint64_t(7));
+    tile.emplace_back(point<std::int16_t>(1, 2), property_map{{"cluster", true}});
+
+    const auto layers = readMessage(mapbox::base::encodeClusterTile(tile, "points", 256));
+    assert(layers.size() == 1u);
+    assert(layers.begin()->first == 3u);
+
+    const auto layer = readMessage(layers.begin()->second);
+    assert(layer.find(15)->second == "2");
+    assert(layer.find(1)->second == "points");
+    assert(layer.find(5)->second == "256");
+    assert(layer.count(2) == 2u);
+    assert(layer.count(3) == 3u);
+    assert(layer.count(4) == 3u);
+
+    const auto first = readMessage(layer.find(2)->second);
+    assert(first.find(1)->second == "7");
+    assert(first.find(3)->second == "1");
+    // MoveTo(1), zigzag(10), zigzag(-3)
+    assert(first.find(4)->second == std::string({9, 20, 5}));
+    assert(first.find(2)->second.size() == 6u);
+
+    const auto second = readMessage(std::next(layer.find(2))->second);
+    assert(second.count(1) == 0u);
+    // Shares the key and value of the first feature.
+    assert(second.find(2)->second.size() == 2u);
+}
+
+void testCache() {
+    feature_collection<double> features;
+    features.emplace_back(point<double>(-10.0, 40.0), property_map{{"name", std::string("a")}});
+    features.emplace_back(point<double>(10.0, 40.0), property_map{{"name", std::string("b")}});
+
+    auto index = std::make_shared<mapbox::supercluster::Supercluster>(features);
+    mapbox::base::ClusterTileCache cache(index, 2u);
+
+    auto tile = cache.getTile(0, 0, 0);
+    assert(!tile->empty());
+    assert(cache.size() == 1u);
+    assert(cache.getTile(0, 0, 0) == tile);
+    assert(*tile == mapbox::base::encodeClusterTile(index->getTile(0, 0, 0)));
+
+    assert(cache.getTile(1, 0, 0)->size() > 0u);
+    assert(cache.getTile(1, 1, 1)->empty());
+    assert(cache.size() == 2u);
+    // z0 was the least recently used tile and got evicted.
+    assert(cache.getTile(0, 0, 0) != tile);
+    assert(*cache.getTile(0, 0, 0) == *tile);
+
+    features.pop_back();
+    cache.reset(std::make_shared<mapbox::supercluster::Supercluster>(features));
+    assert(cache.size() == 0u);
+    assert(*cache.getTile(0, 0, 0) != *tile);
+}
+
+} // namespace
+
+int main() {
+    testEncodeEmpty();
+    testEncode();
+    testCache();
+    return 0;
+}
@@ -0,0 +1,378 @@
+#include <mapbox/image_diff.hpp>
+
+#include <mapbox/pixelmatch.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using Image = std::vector<std::uint8_t>;
+
+// Soft-edged discs on a gradient, so that the images have anti-aliased edges.
+Image render(std::size_t width, std::size_t height, double shift) {
+    Image image(width * height * 4);
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+            double coverage = 0.0;
+            for (int disc = 0; disc < 5; ++disc) {
+                const double cx = width * (0.15 + 0.17 * disc) + shift;
+                const double cy = height * (0.2 + 0.15 * disc);
+                const double d = std::hypot(x + 0.5 - cx, y + 0.5 - cy) - 6.0 - disc;
+                coverage = std::max(coverage, std::min(1.0, std::max(0.0, 0.5 - d)));
+            }
+            std::uint8_t* p = &image[(y * width + x) * 4];
+            p[0] = static_cast<std::uint8_t>(255.0 * (1.0 - coverage) + 20.0 * coverage);
+            p[1] = static_cast<std::uint8_t>((x * 255) / width * (1.0 - coverage));
+            p[2] = static_cast<std::uint8_t>(200.0 * coverage);
+            p[3] = 255;
+        }
+    }
+    return image;
+}
+
+void addNoise(Image& image, std::size_t count, std::mt19937& rng) {
+    std::uniform_int_distribution<std::size_t> pixel(0, image.size() / 4 - 1);
+    std::uniform_int_distribution<int> value(0, 255);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint8_t* p = &image[pixel(rng) * 4];
+        p[0] = static_cast<std::uint8_t>(value(rng));
+        p[1] = static_cast<std::uint8_t>(value(rng));
+        p[2] = static_cast<std::uint8_t>(value(rng));
+    }
+}
+
+// Compares imageDiff with pixelmatch on several band heights and thread counts, checking
+// the count and the output image byte for byte.
+void checkMatchesPixelmatch(const Image& img1, const Image& img2, std::size_t width, std::size_t height) {
+    for (const bool includeAA : {false, true}) {
+        Image expectedOutput(img1.size());
+        const std::uint64_t expected =
+            mapbox::pixelmatch(img1.data(), img2.data(), width, height, expectedOutput.data(), 0.1, includeAA);
+        (void)expected;
+
+        for (const unsigned threads : {1u, 3u}) {
+            for (const std::size_t bandHeight : {1u, 4u, 64u}) {
+                mapbox::base::ImageDiffOptions options;
+                options.includeAA = includeAA;
+                options.threads = threads;
+                options.bandHeight = bandHeight;
+
+                Image output(img1.size());
+                const std::uint64_t count =
+                    mapbox::base::imageDiff(img1.data(), img2.data(), width, height, output.data(), options);
+                assert(count == expected);
+                assert(output == expectedOutput);
+                (void)count;
+            }
+        }
+    }
+}
+
+bool hasColor(const Image& image, std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+    for (std::size_t i = 0; i < image.size(); i += 4) {
+        if (image[i] == r && image[i + 1] == g && image[i + 2] == b) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void testMatchesPixelmatch() {
+    std::mt19937 rng(1);
+    const std::size_t width = 97;
+    const std::size_t height = 211;
+    const Image img1 = render(width, height, 0.0);
+    Image img2 = render(width, height, 0.4);
+    addNoise(img2, 300, rng);
+
+    for (const bool includeAA : {false, true}) {
+        Image expectedOutput(img1.size());
+        const std::uint64_t expected =
+            mapbox::pixelmatch(img1.data(), img2.data(), width, height, expectedOutput.data(), 0.1, includeAA);
+        assert(expected > 0u);
+        (void)expected;
+
+        for (const unsigned threads : {1u, 2u, 3u, 8u}) {
+            for (const std::size_t bandHeight : {1u, 2u, 3u, 7u, 64u, 500u}) {
+                mapbox::base::ImageDiffOptions options;
+                options.includeAA = includeAA;
+                options.threads = threads;
+                options.bandHeight = bandHeight;
+
+                Image output(img1.size());
+                const std::uint64_t count =
+                    mapbox::base::imageDiff(img1.data(), img2.data(), width, height, output.data(), options);
+                assert(count == expected);
+                assert(output == expectedOutput);
+                const std::uint64_t countOnly =
+                    mapbox::base::imageDiff(img1.data(), img2.data(), width, height, nullptr, options);
+                assert(countOnly == expected);
+                (void)count;
+                (void)countOnly;
+            }
+        }
+    }
+}
+
+void testSparse() {
+    std::mt19937 rng(2);
+    const std::size_t width = 64;
+    const std::size_t height = 300;
+    const Image img1 = render(width, height, 0.0);
+
+    // Differences on the first and last rows, in rows a few apart and in an isolated row.
+    Image img2 = img1;
+    for (const std::size_t row : {0u, 1u, 40u, 43u, 48u, 150u, 299u}) {
+        std::uint8_t* p = &img2[(row * width + row % width) * 4];
+        p[0] = static_cast<std::uint8_t>(255 - p[0]);
+        p[1] = static_cast<std::uint8_t>(255 - p[1]);
+    }
+    Image img3 = render(width, height, 0.4);
+    addNoise(img3, 5, rng);
+
+    const std::vector<const Image*> others = {&img1, &img2, &img3};
+    for (const Image* other : others) {
+        Image expectedOutput(img1.size());
+        const std::uint64_t expected =
+            mapbox::pixelmatch(img1.data(), other->data(), width, height, expectedOutput.data(), 0.1);
+        (void)expected;
+
+        for (const std::size_t bandHeight : {1u, 5u, 128u, 300u}) {
+            mapbox::base::ImageDiffOptions options;
+            options.threads = 2;
+            options.bandHeight = bandHeight;
+
+            Image output(img1.size());
+            const std::uint64_t count =
+                mapbox::base::imageDiff(img1.data(), other->data(), width, height, output.data(), options);
+            assert(count == expected);
+            assert(output == expectedOutput);
+            (void)count;
+        }
+    }
+}
+
+void testTranslucent() {
+    std::mt19937 rng(5);
+    const std::size_t width = 70;
+    const std::size_t height = 90;
+    Image img1 = render(width, height, 0.0);
+    Image img2 = render(width, height, 0.4);
+    addNoise(img2, 40, rng);
+
+    // Alpha below 255 everywhere but in a few rows, with some pixels differing in alpha alone.
+    std::uniform_int_distribution<int> alpha(0, 255);
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+            const std::size_t i = (y * width + x) * 4 + 3;
+            if (y % 17 != 0) {
+                img1[i] = img2[i] = static_cast<std::uint8_t>((x * 7 + y * 3) % 255);
+            }
+            if ((x + y) % 23 == 0) {
+                img2[i] = static_cast<std::uint8_t>(alpha(rng));
+            }
+        }
+    }
+
+    Image output(img1.size());
+    mapbox::pixelmatch(img1.data(), img2.data(), width, height, output.data(), 0.1);
+    const bool mismatched = hasColor(output, 255, 0, 0);
+    assert(mismatched);
+    (void)mismatched;
+    checkMatchesPixelmatch(img1, img2, width, height);
+}
+
+void testIdenticalRunsNearEdges() {
+    std::mt19937 rng(6);
+    const std::size_t width = 120;
+    const std::size_t height = 100;
+    const Image img1 = render(width, height, 0.0);
+    const Image shifted = render(width, height, 0.4);
+
+    // Only some pixels of some rows take the shifted edges, so changed rows hold runs of
+    // identical pixels of every length right next to anti-aliased ones.
+    Image img2 = img1;
+    std::bernoulli_distribution changedRow(0.3);
+    std::bernoulli_distribution changedPixel(0.25);
+    for (std::size_t y = 0; y < height; ++y) {
+        if (!changedRow(rng)) {
+            continue;
+        }
+        for (std::size_t x = 0; x < width; ++x) {
+            if (changedPixel(rng)) {
+                std::memcpy(&img2[(y * width + x) * 4], &shifted[(y * width + x) * 4], 4);
+            }
+        }
+    }
+    addNoise(img2, 10, rng);
+
+    Image output(img1.size());
+    mapbox::pixelmatch(img1.data(), img2.data(), width, height, output.data(), 0.1);
+    const bool mismatched = hasColor(output, 255, 0, 0);
+    const bool antialiased = hasColor(output, 255, 255, 0);
+    assert(mismatched);
+    assert(antialiased);
+    (void)mismatched;
+    (void)antialiased;
+    checkMatchesPixelmatch(img1, img2, width, height);
+}
+
+void testBudget() {
+    std::mt19937 rng(3);
+    const std::size_t width = 50;
+    const std::size_t height = 400;
+    const Image img1 = render(width, height, 0.0);
+    Image img2 = img1;
+    addNoise(img2, 2000, rng);
+    const std::uint64_t expected = mapbox::pixelmatch(img1.data(), img2.data(), width, height);
+    assert(expected > 1000u);
+    (void)expected;
+
+    for (const unsigned threads : {1u, 4u}) {
+        mapbox::base::ImageDiffOptions options;
+        options.threads = threads;
+        options.bandHeight = 16;
+
+        // A budget the images stay within does not change the result.
+        options.maxMismatches = expected;
+        const std::uint64_t count = mapbox::base::imageDiff(img1.data(), img2.data(), width, height, nullptr, options);
+        assert(count == expected);
+        (void)count;
+
+        // Exceeding the budget stops the comparison early.
+        options.maxMismatches = 10;
+        const std::uint64_t partial =
+            mapbox::base::imageDiff(img1.data(), img2.data(), width, height, nullptr, options);
+        assert(partial > 10u);
+        assert(partial < expected);
+        (void)partial;
+
+        const bool withinBudget = mapbox::base::imagesMatch(img1.data(), img2.data(), width, height, expected, options);
+        const bool overBudget =
+            mapbox::base::imagesMatch(img1.data(), img2.data(), width, height, expected - 1, options);
+        const bool overZero = mapbox::base::imagesMatch(img1.data(), img2.data(), width, height, 0, options);
+        const bool same = mapbox::base::imagesMatch(img1.data(), img1.data(), width, height);
+        assert(withinBudget);
+        assert(!overBudget);
+        assert(!overZero);
+        assert(same);
+        (void)withinBudget;
+        (void)overBudget;
+        (void)overZero;
+        (void)same;
+    }
+}
+
+void testSummary() {
+    std::mt19937 rng(4);
+    const std::size_t width = 150;
+    const std::size_t height = 100;
+    const Image img1 = render(width, height, 0.0);
+    Image img2 = render(width, height, 0.4);
+    addNoise(img2, 200, rng);
+
+    Image output(img1.size());
+    const std::uint64_t expected = mapbox::pixelmatch(img1.data(), img2.data(), width, height, output.data());
+    (void)expected;
+
+    using Summary = mapbox::base::ImageDiffSummary;
+    for (const std::size_t bandHeight : {1u, 40u}) {
+        mapbox::base::ImageDiffOptions options;
+        options.threads = 3;
+        options.bandHeight = bandHeight;
+        Summary summary;
+        const std::uint64_t count =
+            mapbox::base::imageDiff(img1.data(), img2.data(), width, height, nullptr, &summary, options);
+        assert(count == expected);
+        (void)count;
+        assert(summary.columns() == 5u && summary.rows() == 4u);
+
+        // Rebuild the summary from the red pixels of the diff image.
+        Summary reference;
+        reference.reset(width, height);
+        for (std::uint32_t y = 0; y < height; ++y) {
+            for (std::uint32_t x = 0; x < width; ++x) {
+                const std::uint8_t* p = &output[(y * width + x) * 4];
+                if (p[0] == 255 && p[1] == 0 && p[2] == 0) {
+                    reference.add(x, y);
+                }
+            }
+        }
+        for (std::size_t row = 0; row < summary.rows(); ++row) {
+            for (std::size_t column = 0; column < summary.columns(); ++column) {
+                const Summary::Tile& tile = summary.tile(column, row);
+                const Summary::Tile& expectedTile = reference.tile(column, row);
+                assert(tile.count == expectedTile.count);
+                assert(tile.count == 0 || (tile.box.minX == expectedTile.box.minX &&
+                                           tile.box.minY == expectedTile.box.minY &&
+                                           tile.box.maxX == expectedTile.box.maxX &&
+                                           tile.box.maxY == expectedTile.box.maxY));
+                (void)tile;
+                (void)expectedTile;
+            }
+        }
+    }
+}
+
+void testRegions() {
+    const std::size_t width = 200;
+    const std::size_t height = 120;
+    const Image img1(width * height * 4, 255);
+    Image img2 = img1;
+    auto paint = [&](std::size_t x, std::size_t y) {
+        img2[(y * width + x) * 4] = 0;
+        img2[(y * width + x) * 4 + 1] = 0;
+    };
+    // Two blocks in diagonally touching tiles, and one far away.
+    for (std::size_t y = 20; y < 30; ++y) {
+        for (std::size_t x = 10; x < 30; ++x) {
+            paint(x, y);
+        }
+    }
+    paint(40, 40);
+    paint(150, 100);
+    paint(170, 110);
+
+    mapbox::base::ImageDiffSummary summary;
+    const std::uint64_t count = mapbox::base::imageDiff(img1.data(), img2.data(), width, height, nullptr, &summary);
+    assert(count == 203u);
+    (void)count;
+    const auto regions = summary.regions();
+    assert(regions.size() == 2u);
+    assert(regions[0].minX == 10u && regions[0].minY == 20u && regions[0].maxX == 40u && regions[0].maxY == 40u);
+    assert(regions[1].minX == 150u && regions[1].minY == 100u && regions[1].maxX == 170u && regions[1].maxY == 110u);
+}
+
+void testEmpty() {
+    mapbox::base::ImageDiffOptions options;
+    options.threads = 4;
+    const std::uint64_t empty = mapbox::base::imageDiff(nullptr, nullptr, 0u, 0u, nullptr, options);
+    assert(empty == 0u);
+    (void)empty;
+
+    const Image image = render(16, 16, 0.0);
+    const std::uint64_t same = mapbox::base::imageDiff(image.data(), image.data(), 16u, 16u);
+    assert(same == 0u);
+    (void)same;
+}
+
+} // namespace
+
+int main() {
+    testMatchesPixelmatch();
+    testSparse();
+    testTranslucent();
+    testIdenticalRunsNearEdges();
+    testBudget();
+    testSummary();
+    testRegions();
+    testEmpty();
+
+    return 0;
+}
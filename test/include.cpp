@@ -1,9 +1,18 @@
+#include <mapbox/batch_query.hpp>
+#include <mapbox/batch_ruler.hpp>
 #include <mapbox/cheap_ruler.hpp>
+#include <mapbox/cluster_tile.hpp>
+#include <mapbox/dynamic_kdbush.hpp>
+#include <mapbox/flatbush.hpp>
+#include <mapbox/geodesic_ruler.hpp>
 #include <mapbox/geojson.hpp>
 #include <mapbox/geojsonvt.hpp>
 #include <mapbox/geometry.hpp>
+#include <mapbox/image_diff.hpp>
 #include <mapbox/pixelmatch.hpp>
+#include <mapbox/prepared_line.hpp>
 #include <mapbox/shelf-pack.hpp>
+#include <mapbox/tile_rulers.hpp>
 #include <mapbox/variant.hpp>
 
 #include <rapidjson/document.h>
@@ -27,6 +36,13 @@ int main() {
     mapbox::cheap_ruler::CheapRuler cheapRuler(32.00);
     mapbox::geojsonvt::detail::vt_point point(0, 0);
     mapbox::ShelfPack sprite(64, 64);
+    mapbox::base::BatchQuery<double> batchQuery;
+    mapbox::base::DynamicKDBush<double> dynamicKDBush;
+    mapbox::base::Flatbush<double> flatbush(1);
+    mapbox::base::BatchRuler batchRuler(32.00);
+    mapbox::base::PreparedLine preparedLine({}, cheapRuler);
+    mapbox::base::AutoRuler autoRuler;
+    mapbox::base::ImageDiffOptions imageDiffOptions;
 
     rapidjson::Document rapidjsonDocument;
 
@@ -43,8 +59,17 @@ int main() {
     (void)cheapRuler;
     (void)sprite;
     (void)point;
+    (void)batchQuery;
+    (void)dynamicKDBush;
+    (void)flatbush;
+    (void)batchRuler;
+    (void)preparedLine;
+    (void)autoRuler;
+    (void)imageDiffOptions;
 
     mapbox::pixelmatch(nullptr, nullptr, 0u, 0u, nullptr, 0.0);
+    mapbox::base::encodeClusterTile({});
+    mapbox::base::TileRulers::get(0, 0);
 
     return 0;
 }
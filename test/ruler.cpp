@@ -0,0 +1,471 @@
+#include <mapbox/batch_ruler.hpp>
+#include <mapbox/geodesic_ruler.hpp>
+#include <mapbox/prepared_line.hpp>
+#include <mapbox/tile_rulers.hpp>
+
+#include <mapbox/cheap_ruler.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using mapbox::base::BatchRuler;
+using mapbox::cheap_ruler::CheapRuler;
+using mapbox::cheap_ruler::point;
+
+bool near(double a, double b) {
+    return std::abs(a - b) <= 1e-12 * std::max(1.0, std::abs(b));
+}
+
+struct Line {
+    std::vector<double> xs;
+    std::vector<double> ys;
+};
+
+Line randomWalk(std::size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<double> step(-0.01, 0.01);
+    Line line;
+    double x = 13.4;
+    double y = 52.5;
+    for (std::size_t i = 0; i < count; ++i) {
+        line.xs.push_back(x += step(rng));
+        line.ys.push_back(y += step(rng));
+    }
+    return line;
+}
+
+void testBatchDistances() {
+    std::mt19937 rng(1);
+    CheapRuler ruler(52.5, CheapRuler::Meters);
+    BatchRuler batch(ruler);
+
+    // Odd sizes exercise the scalar tail after the vector loop.
+    for (std::size_t count : {0u, 1u, 3u, 7u, 1001u}) {
+        const Line to = randomWalk(count, rng);
+        const Line from = randomWalk(count, rng);
+        const point origin(13.4, 52.5);
+        std::vector<double> out(count);
+
+        batch.distances(origin, to.xs.data(), to.ys.data(), count, out.data());
+        for (std::size_t i = 0; i < count; ++i) {
+            assert(near(out[i], ruler.distance(origin, point(to.xs[i], to.ys[i]))));
+        }
+
+        batch.distances(from.xs.data(), from.ys.data(), to.xs.data(), to.ys.data(), count, out.data());
+        for (std::size_t i = 0; i < count; ++i) {
+            assert(near(out[i], ruler.distance(point(from.xs[i], from.ys[i]), point(to.xs[i], to.ys[i]))));
+        }
+    }
+}
+
+void testBatchLineDistance() {
+    std::mt19937 rng(2);
+    CheapRuler ruler(52.5);
+    BatchRuler batch(ruler);
+
+    // Longer than one block of segment lengths.
+    for (std::size_t count : {0u, 1u, 2u, 257u, 258u, 5000u}) {
+        const Line line = randomWalk(count, rng);
+        mapbox::cheap_ruler::line_string points;
+        for (std::size_t i = 0; i < count; ++i) {
+            points.emplace_back(line.xs[i], line.ys[i]);
+        }
+        assert(near(batch.lineDistance(line.xs.data(), line.ys.data(), count), ruler.lineDistance(points)));
+    }
+}
+
+void testBatchKernels() {
+    std::mt19937 rng(3);
+    const Line a = randomWalk(99, rng);
+    const Line b = randomWalk(99, rng);
+    std::vector<double> expected(99);
+    std::vector<double> out(99);
+
+    for (std::size_t step : {0u, 1u}) {
+        const mapbox::base::internal::ScaledDistanceArgs scalar{
+            a.xs.data(), a.ys.data(), b.xs.data(), b.ys.data(), step, 68.0, 111.0, expected.data()};
+        mapbox::base::internal::scaledDistancesScalar(scalar, 0, 99);
+
+        auto args = scalar;
+        args.out = out.data();
+        mapbox::base::internal::scaledDistancesKernel()(args, 99);
+        for (std::size_t i = 0; i < 99; ++i) {
+            assert(near(out[i], expected[i]));
+        }
+    }
+}
+
+void testTileRulers() {
+    using mapbox::base::TileRulers;
+    const point a(-0.2, 51.5);
+    const point b(0.1, 51.7);
+
+    for (std::uint8_t z : {0, 1, 5, 12, 16, 17, 20}) {
+        const std::uint32_t rows = std::uint32_t(1) << z;
+        for (std::uint32_t y : {0u, rows / 3, rows / 2, rows - 1}) {
+            auto cached = TileRulers::get(y, z);
+            auto direct = CheapRuler::fromTile(y, z);
+            assert(cached.distance(a, b) == direct.distance(a, b));
+            assert(cached.bearing(a, b) == direct.bearing(a, b));
+        }
+    }
+
+    // The first use of a zoom builds its table, which must be safe from several threads.
+    std::vector<std::thread> threads;
+    std::vector<double> results(4);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([&results, i, a, b] { results[i] = TileRulers::get(4321, 13).distance(a, b); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (const double result : results) {
+        assert(result == CheapRuler::fromTile(4321, 13).distance(a, b));
+    }
+}
+
+void assertNear(const point& a, const point& b) {
+    assert(near(a.x, b.x) && near(a.y, b.y));
+}
+
+void assertNear(const mapbox::cheap_ruler::line_string& a, const mapbox::cheap_ruler::line_string& b) {
+    assert(a.size() == b.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        assertNear(a[i], b[i]);
+    }
+}
+
+void testPreparedLine() {
+    std::mt19937 rng(4);
+    const Line walk = randomWalk(3000, rng);
+    mapbox::cheap_ruler::line_string line;
+    for (std::size_t i = 0; i < walk.xs.size(); ++i) {
+        line.emplace_back(walk.xs[i], walk.ys[i]);
+    }
+    // A repeated vertex gives a segment of zero length.
+    line.insert(line.begin() + 100, line[100]);
+
+    CheapRuler ruler(52.5);
+    const mapbox::base::PreparedLine prepared(line, ruler);
+    const double length = ruler.lineDistance(line);
+    assert(near(prepared.length(), length));
+
+    std::uniform_real_distribution<double> x(12.5, 14.5);
+    std::uniform_real_distribution<double> y(51.5, 53.5);
+    for (int i = 0; i < 500; ++i) {
+        const point p(x(rng), y(rng));
+        const auto expected = ruler.pointOnLine(line, p);
+        const auto actual = prepared.pointOnLine(p);
+        assertNear(std::get<0>(actual), std::get<0>(expected));
+        assert(std::get<1>(actual) == std::get<1>(expected));
+        assert(near(std::get<2>(actual), std::get<2>(expected)));
+    }
+
+    // Points on vertices are equally close to two segments.
+    for (std::size_t i : {0u, 1u, 100u, 101u, 1500u, 3000u}) {
+        const auto expected = ruler.pointOnLine(line, line[i]);
+        const auto actual = prepared.pointOnLine(line[i]);
+        assert(std::get<1>(actual) == std::get<1>(expected));
+        assert(prepared.distanceAlong(std::get<1>(actual), std::get<2>(actual)) <= length);
+    }
+
+    std::uniform_real_distribution<double> distance(-1.0, length + 1.0);
+    for (int i = 0; i < 500; ++i) {
+        const double start = distance(rng);
+        const double stop = distance(rng);
+        assertNear(prepared.along(start), ruler.along(line, start));
+        assertNear(prepared.lineSliceAlong(start, stop), ruler.lineSliceAlong(start, stop, line));
+    }
+    assertNear(prepared.lineSliceAlong(0.0, length), ruler.lineSliceAlong(0.0, length, line));
+
+    for (int i = 0; i < 100; ++i) {
+        const point start(x(rng), y(rng));
+        const point stop(x(rng), y(rng));
+        assertNear(prepared.lineSlice(start, stop), ruler.lineSlice(start, stop, line));
+    }
+}
+
+void testPreparedLineShort() {
+    CheapRuler ruler(0.0);
+    const mapbox::base::PreparedLine empty({}, ruler);
+    assert(empty.length() == 0.0);
+    assert(std::get<1>(empty.pointOnLine({1.0, 1.0})) == 0u);
+    assert(empty.lineSliceAlong(0.0, 1.0).empty());
+
+    const mapbox::base::PreparedLine single({{1.0, 2.0}}, ruler);
+    assert(std::get<0>(single.pointOnLine({0.0, 0.0})) == point(1.0, 2.0));
+    assert(single.along(10.0) == point(1.0, 2.0));
+}
+
+void testGeodesicRuler() {
+    using mapbox::base::GeodesicRuler;
+
+    // Vincenty's own example, from Flinders Peak to Buninyong.
+    const point flindersPeak(144.0 + 25.0 / 60.0 + 29.52440 / 3600.0, -(37.0 + 57.0 / 60.0 + 3.72030 / 3600.0));
+    const point buninyong(143.0 + 55.0 / 60.0 + 35.38390 / 3600.0, -(37.0 + 39.0 / 60.0 + 10.15610 / 3600.0));
+    const double bearing = 306.0 + 52.0 / 60.0 + 5.37 / 3600.0 - 360.0;
+
+    GeodesicRuler metres(CheapRuler::Meters);
+    assert(std::abs(metres.distance(flindersPeak, buninyong) - 54972.271) < 1e-3);
+    assert(std::abs(metres.bearing(flindersPeak, buninyong) - bearing) < 1e-5);
+
+    const point destination = metres.destination(flindersPeak, 54972.271, bearing);
+    assert(std::abs(destination.x - buninyong.x) < 1e-7);
+    assert(std::abs(destination.y - buninyong.y) < 1e-7);
+
+    GeodesicRuler kilometres;
+    assert(near(kilometres.distance(flindersPeak, buninyong) * 1000.0, metres.distance(flindersPeak, buninyong)));
+    assert(kilometres.distance(flindersPeak, flindersPeak) == 0.0);
+
+    // Long lines and the antimeridian.
+    const point tokyo(139.69, 35.69);
+    const point sanFrancisco(-122.42, 37.77);
+    const double distance = kilometres.distance(tokyo, sanFrancisco);
+    assert(distance > 8200.0 && distance < 8300.0);
+    const point there = kilometres.destination(tokyo, distance, kilometres.bearing(tokyo, sanFrancisco));
+    assert(std::abs(std::remainder(there.x - sanFrancisco.x, 360.0)) < 1e-7);
+    assert(std::abs(there.y - sanFrancisco.y) < 1e-7);
+
+    const mapbox::cheap_ruler::line_string line = {tokyo, sanFrancisco, flindersPeak};
+    const double length = kilometres.lineDistance(line);
+    assert(near(length, distance + kilometres.distance(sanFrancisco, flindersPeak)));
+    assert(kilometres.along(line, -1.0) == tokyo);
+    assert(kilometres.along(line, length + 1.0) == flindersPeak);
+    const point middle = kilometres.along(line, distance / 2.0);
+    assert(std::abs(kilometres.distance(tokyo, middle) - distance / 2.0) < 1e-6);
+
+    const auto slice = kilometres.lineSliceAlong(1000.0, distance + 500.0, line);
+    assert(slice.size() == 3u && slice[1] == sanFrancisco);
+    assert(std::abs(kilometres.lineDistance(slice) - (distance - 500.0)) < 1e-6);
+    assert(kilometres.lineSliceAlong(0.0, 1.0, {tokyo}).empty());
+}
+
+void testGeodesicArea() {
+    using mapbox::base::GeodesicRuler;
+    GeodesicRuler ruler;
+
+    // An eighth of the WGS84 ellipsoid, bounded by two meridians and the equator.
+    const mapbox::cheap_ruler::polygon octant = {{{0.0, 0.0}, {90.0, 0.0}, {0.0, 90.0}, {0.0, 0.0}}};
+    assert(std::abs(ruler.area(octant) - 510065621.724 / 8.0) < 1.0);
+
+    // Small polygons agree with CheapRuler, whatever the winding, and holes are subtracted.
+    const mapbox::cheap_ruler::linear_ring square = {
+        {13.0, 52.0}, {13.1, 52.0}, {13.1, 52.1}, {13.0, 52.1}, {13.0, 52.0}};
+    const mapbox::cheap_ruler::linear_ring reversed(square.rbegin(), square.rend());
+    const mapbox::cheap_ruler::linear_ring hole = {
+        {13.02, 52.02}, {13.04, 52.02}, {13.04, 52.04}, {13.02, 52.04}, {13.02, 52.02}};
+    CheapRuler cheap(52.05);
+    const double area = ruler.area({square});
+    assert(std::abs(area - cheap.area({square})) < 1e-3 * area);
+    assert(near(ruler.area({reversed}), area));
+    assert(std::abs(ruler.area({square, hole}) - cheap.area({square, hole})) < 1e-3 * area);
+
+    // A ring around the pole encloses the cap, not the rest of the globe.
+    mapbox::cheap_ruler::linear_ring cap;
+    for (int i = 0; i <= 3600; ++i) {
+        cap.emplace_back(i / 10.0 - 180.0, 80.0);
+    }
+    const double a = mapbox::base::internal::kWgs84A / 1000.0;
+    const double q = mapbox::base::internal::authalicQ(std::sin(80.0 * M_PI / 180.0));
+    const double capArea = M_PI * a * a * (mapbox::base::internal::authalicQ(1.0) - q);
+    assert(std::abs(ruler.area({cap}) - capArea) < 1e-4 * capArea);
+    const mapbox::cheap_ruler::linear_ring capReversed(cap.rbegin(), cap.rend());
+    assert(std::abs(ruler.area({capReversed}) - ruler.area({cap})) < 1e-9 * capArea);
+}
+
+void testGeodesicPointOnLine() {
+    using mapbox::base::GeodesicRuler;
+    GeodesicRuler ruler;
+
+    // A point off the middle of a long segment projects back onto the middle.
+    const mapbox::cheap_ruler::line_string line = {{0.0, 50.0}, {10.0, 52.0}, {12.0, 40.0}};
+    const double first = ruler.distance(line[0], line[1]);
+    const point middle = ruler.along(line, first / 2.0);
+    const point p = ruler.destination(middle, 20.0, ruler.bearing(middle, line[1]) + 90.0);
+    const auto result = ruler.pointOnLine(line, p);
+    assert(std::get<1>(result) == 0u);
+    assert(std::abs(std::get<2>(result) - 0.5) < 1e-6);
+    assert(ruler.distance(std::get<0>(result), middle) < 1e-6);
+
+    // Points beyond the ends snap to the end points.
+    const auto end = ruler.pointOnLine(line, {12.5, 38.0});
+    assert(std::get<0>(end) == line[2] && std::get<1>(end) == 1u && std::get<2>(end) == 1.0);
+    assert(std::get<0>(ruler.pointOnLine(line, {-1.0, 49.0})) == line[0]);
+
+    // No point sampled along the segments is closer.
+    std::mt19937 rng(6);
+    std::uniform_real_distribution<double> offset(-0.05, 0.05);
+    const mapbox::cheap_ruler::line_string walk = {{13.40, 52.50}, {13.43, 52.52}, {13.45, 52.49}, {13.50, 52.51}};
+    for (int i = 0; i < 20; ++i) {
+        const point q(13.45 + offset(rng), 52.5 + offset(rng));
+        const double closest = ruler.distance(q, std::get<0>(ruler.pointOnLine(walk, q)));
+        for (std::size_t j = 0; j + 1 < walk.size(); ++j) {
+            const mapbox::cheap_ruler::line_string segment = {walk[j], walk[j + 1]};
+            const double length = ruler.lineDistance(segment);
+            for (int k = 0; k <= 200; ++k) {
+                assert(closest <= ruler.distance(q, ruler.along(segment, length * k / 200.0)) + 1e-9);
+            }
+        }
+    }
+
+    const point a = ruler.along(line, 100.0);
+    const point b = ruler.along(line, first + 300.0);
+    const point start = ruler.destination(a, 5.0, ruler.bearing(a, line[1]) - 90.0);
+    const point stop = ruler.destination(b, 5.0, ruler.bearing(b, line[2]) + 90.0);
+    const auto slice = ruler.lineSlice(stop, start, line);
+    assert(slice.size() == 3u && slice[1] == line[1]);
+    assert(std::abs(ruler.lineDistance(slice) - (first + 200.0)) < 1e-3);
+    assert(ruler.lineSlice(start, stop, {line[0]}).empty());
+}
+
+void testGeodesicBuffer() {
+    using mapbox::base::GeodesicRuler;
+    GeodesicRuler ruler;
+
+    for (double latitude : {0.0, 45.0, -70.0, 85.0}) {
+        const point p(20.0, latitude);
+        const auto box = ruler.bufferPoint(p, 100.0);
+        double maxX = -180.0;
+        for (int bearing = 0; bearing < 3600; ++bearing) {
+            const point q = ruler.destination(p, 100.0, bearing / 10.0);
+            assert(CheapRuler::insideBBox(q, box));
+            maxX = std::max(maxX, q.x);
+        }
+        // The box is tight.
+        assert(box.max.x - maxX < 1e-5);
+        assert(std::abs(box.max.y - ruler.destination(p, 100.0, 0.0).y) < 1e-9);
+    }
+
+    // Buffers that reach a pole span all longitudes.
+    const auto polar = ruler.bufferPoint({20.0, 89.9}, 50.0);
+    assert(polar.max.y == 90.0 && polar.min.x == -160.0 && polar.max.x == 200.0);
+
+    const mapbox::cheap_ruler::box bbox({10.0, 40.0}, {12.0, 60.0});
+    const auto buffered = ruler.bufferBBox(bbox, 30.0);
+    for (const point& corner : {bbox.min, bbox.max, point(bbox.min.x, bbox.max.y), point(bbox.max.x, bbox.min.y)}) {
+        const auto around = ruler.bufferPoint(corner, 30.0);
+        assert(CheapRuler::insideBBox(around.min, buffered) && CheapRuler::insideBBox(around.max, buffered));
+    }
+}
+
+void testAutoRuler() {
+    using mapbox::base::AutoRuler;
+    using mapbox::base::GeodesicRuler;
+
+    std::mt19937 rng(5);
+    AutoRuler ruler;
+    GeodesicRuler geodesic;
+    for (double latitude : {0.0, 35.0, 60.0, -70.0}) {
+        // Short distances use the cheap approximation at their mid-latitude.
+        const point a(10.0, latitude);
+        const point b(10.05, latitude + 0.01);
+        assert(ruler.distance(a, b) == CheapRuler((a.y + b.y) / 2.0).distance(a, b));
+
+        for (double spread : {0.1, 1.0, 10.0, 60.0}) {
+            std::uniform_real_distribution<double> x(-spread, spread);
+            std::uniform_real_distribution<double> y(std::max(-89.0, latitude - spread),
+                                                     std::min(89.0, latitude + spread));
+            for (int i = 0; i < 200; ++i) {
+                const point p(x(rng), y(rng));
+                const point q(x(rng), y(rng));
+                const double expected = geodesic.distance(p, q);
+                assert(std::abs(ruler.distance(p, q) - expected) <= 1e-3 * expected);
+
+                // Bearing errors in radians are cross-track errors relative to the distance.
+                const double bearingError = std::remainder(ruler.bearing(p, q) - geodesic.bearing(p, q), 360.0);
+                assert(std::abs(bearingError) * M_PI / 180.0 <= 1e-3);
+
+                const double bearing = geodesic.bearing(p, q);
+                const point there = ruler.destination(p, expected, bearing);
+                assert(geodesic.distance(there, geodesic.destination(p, expected, bearing)) <= 1e-3 * expected);
+            }
+        }
+    }
+
+    // Bearings still switch once the meridians converge.
+    CheapRuler cheap(60.0);
+    assert(ruler.bearing({10.0, 60.0}, {10.05, 60.0}) == cheap.bearing({10.0, 60.0}, {10.05, 60.0}));
+    assert(ruler.bearing({10.0, 60.0}, {11.0, 60.0}) == geodesic.bearing({10.0, 60.0}, {11.0, 60.0}));
+}
+
+void testAutoRulerAnyLatitude() {
+    using mapbox::base::AutoRuler;
+
+    // Short segments take the cheap path at any latitude short of the poles, not only
+    // near one reference latitude.
+    AutoRuler ruler;
+    for (double latitude : {-78.0, -41.0, 3.0, 17.0, 44.5, 63.0, 75.0}) {
+        for (double length : {0.005, 0.1, 1.0}) {
+            for (double bearing = -180.0; bearing < 180.0; bearing += 45.0) {
+                const point a(25.0, latitude);
+                const point b = CheapRuler(latitude).destination(a, length, bearing);
+                CheapRuler mid((a.y + b.y) / 2.0);
+                const double dist = mid.distance(a, b);
+                assert(ruler.errorBound(a, b, dist) <= 1e-3);
+                assert(ruler.bearingErrorBound(a, b) <= 1e-3);
+                assert(ruler.distance(a, b) == dist);
+                assert(ruler.bearing(a, b) == mid.bearing(a, b));
+            }
+        }
+    }
+}
+
+void testAutoRulerShapes() {
+    using mapbox::base::AutoRuler;
+    using mapbox::base::GeodesicRuler;
+
+    AutoRuler ruler;
+    GeodesicRuler geodesic;
+
+    // Short lines use CheapRuler at the middle of their latitude range throughout.
+    const mapbox::cheap_ruler::line_string walk = {{13.40, 52.50}, {13.43, 52.52}, {13.45, 52.49}, {13.50, 52.51}};
+    CheapRuler cheap(52.505);
+    const point p(13.44, 52.51);
+    assert(ruler.along(walk, 2.0) == cheap.along(walk, 2.0));
+    assert(ruler.pointOnLine(walk, p) == cheap.pointOnLine(walk, p));
+    assert(ruler.lineSlice(p, walk[3], walk) == cheap.lineSlice(p, walk[3], walk));
+    assert(ruler.lineSliceAlong(1.0, 3.0, walk) == cheap.lineSliceAlong(1.0, 3.0, walk));
+    const auto box = ruler.bufferPoint(p, 1.0);
+    CheapRuler atP(p.y);
+    assert(box.min == atP.bufferPoint(p, 1.0).min && box.max == atP.bufferPoint(p, 1.0).max);
+    const mapbox::cheap_ruler::polygon square = {
+        {{13.40, 52.49}, {13.45, 52.49}, {13.45, 52.51}, {13.40, 52.51}, {13.40, 52.49}}};
+    assert(ruler.area(square) == CheapRuler(52.5).area(square));
+
+    // Long ones are solved on the ellipsoid.
+    const mapbox::cheap_ruler::line_string long_ = {{13.4, 52.5}, {-74.0, 40.7}};
+    const point q(-30.0, 55.0);
+    assert(ruler.along(long_, 3000.0) == geodesic.along(long_, 3000.0));
+    assert(ruler.pointOnLine(long_, q) == geodesic.pointOnLine(long_, q));
+    assert(ruler.lineSlice(q, long_[1], long_) == geodesic.lineSlice(q, long_[1], long_));
+    assert(ruler.lineSliceAlong(1000.0, 2000.0, long_) == geodesic.lineSliceAlong(1000.0, 2000.0, long_));
+    const auto wide = ruler.bufferPoint(q, 500.0);
+    assert(wide.min == geodesic.bufferPoint(q, 500.0).min && wide.max == geodesic.bufferPoint(q, 500.0).max);
+    const mapbox::cheap_ruler::polygon large = {{{0.0, 40.0}, {30.0, 40.0}, {30.0, 70.0}, {0.0, 70.0}, {0.0, 40.0}}};
+    assert(ruler.area(large) == geodesic.area(large));
+}
+
+} // namespace
+
+int main() {
+    testBatchDistances();
+    testBatchLineDistance();
+    testBatchKernels();
+    testTileRulers();
+    testPreparedLine();
+    testPreparedLineShort();
+    testGeodesicRuler();
+    testGeodesicArea();
+    testGeodesicPointOnLine();
+    testGeodesicBuffer();
+    testAutoRuler();
+    testAutoRulerAnyLatitude();
+    testAutoRulerShapes();
+
+    return 0;
+}
@@ -0,0 +1,471 @@
+#include <mapbox/batch_query.hpp>
+#include <mapbox/dynamic_kdbush.hpp>
+#include <mapbox/flatbush.hpp>
+
+#include <kdbush.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Point = std::pair<double, double>;
+using Match = std::pair<std::size_t, std::size_t>;
+
+std::vector<Point> randomPoints(std::size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    std::vector<Point> points;
+    for (std::size_t i = 0; i < count; ++i) {
+        points.emplace_back(coordinate(rng), coordinate(rng));
+    }
+    return points;
+}
+
+void testBatchRange() {
+    std::mt19937 rng(1);
+    const auto points = randomPoints(10000, rng);
+    kdbush::KDBush<Point> index(points, 16);
+
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    std::vector<mapbox::base::BatchQuery<double>::Box> boxes;
+    for (int i = 0; i < 200; ++i) {
+        const double x = coordinate(rng);
+        const double y = coordinate(rng);
+        boxes.push_back({x, y, x + 20.0, y + 30.0});
+    }
+
+    std::vector<Match> expected;
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        index.range(boxes[i].minX, boxes[i].minY, boxes[i].maxX, boxes[i].maxY, [&](std::size_t id) {
+            expected.emplace_back(i, id);
+        });
+    }
+
+    mapbox::base::BatchQuery<double> batch;
+    for (int run = 0; run < 2; ++run) {
+        std::vector<Match> actual;
+        batch.range(index, boxes.data(), boxes.size(), [&](std::size_t query, std::size_t id) {
+            actual.emplace_back(query, id);
+        });
+        std::sort(expected.begin(), expected.end());
+        std::sort(actual.begin(), actual.end());
+        assert(!actual.empty());
+        assert(actual == expected);
+    }
+}
+
+void testBatchWithin() {
+    std::mt19937 rng(2);
+    const auto points = randomPoints(10000, rng);
+    kdbush::KDBush<Point> index(points);
+
+    std::vector<mapbox::base::BatchQuery<double>::Circle> circles;
+    for (const auto& p : randomPoints(200, rng)) {
+        circles.push_back({p.first, p.second, 15.0});
+    }
+
+    std::vector<Match> expected;
+    for (std::size_t i = 0; i < circles.size(); ++i) {
+        index.within(circles[i].x, circles[i].y, circles[i].r, [&](std::size_t id) { expected.emplace_back(i, id); });
+    }
+
+    std::vector<Match> actual;
+    mapbox::base::BatchQuery<double> batch;
+    batch.within(index, circles.data(), circles.size(), [&](std::size_t query, std::size_t id) {
+        actual.emplace_back(query, id);
+    });
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    assert(!actual.empty());
+    assert(actual == expected);
+}
+
+void testBatchEmpty() {
+    kdbush::KDBush<Point> index(std::vector<Point>{{1.0, 1.0}});
+    mapbox::base::BatchQuery<double> batch;
+    bool visited = false;
+    batch.range(index, nullptr, 0, [&](std::size_t, std::size_t) { visited = true; });
+    assert(!visited);
+
+    // Degenerate batch bounds: all queries share one centre.
+    const mapbox::base::BatchQuery<double>::Box box{0.0, 0.0, 2.0, 2.0};
+    const std::vector<mapbox::base::BatchQuery<double>::Box> boxes(3, box);
+    std::size_t matches = 0;
+    batch.range(index, boxes.data(), boxes.size(), [&](std::size_t, std::size_t id) {
+        assert(id == 0u);
+        ++matches;
+    });
+    assert(matches == 3u);
+}
+
+// Compares a range and a radius query at a random place with a brute force search.
+void checkDynamic(const mapbox::base::DynamicKDBush<double>& index,
+                  const std::vector<Point>& reference,
+                  const std::vector<bool>& present,
+                  std::mt19937& rng) {
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    const double x = coordinate(rng);
+    const double y = coordinate(rng);
+    std::set<std::uint32_t> expected;
+    std::set<std::uint32_t> actual;
+    for (std::uint32_t id = 0; id < reference.size(); ++id) {
+        const Point& p = reference[id];
+        if (present[id] && p.first >= x && p.first <= x + 100.0 && p.second >= y && p.second <= y + 100.0) {
+            expected.insert(id);
+        }
+    }
+    index.range(x, y, x + 100.0, y + 100.0, [&](std::uint32_t id) {
+        const bool inserted = actual.insert(id).second;
+        assert(inserted);
+        (void)inserted;
+    });
+    assert(actual == expected);
+
+    expected.clear();
+    actual.clear();
+    for (std::uint32_t id = 0; id < reference.size(); ++id) {
+        const double dx = reference[id].first - x;
+        const double dy = reference[id].second - y;
+        if (present[id] && dx * dx + dy * dy <= 50.0 * 50.0) {
+            expected.insert(id);
+        }
+    }
+    index.within(x, y, 50.0, [&](std::uint32_t id) {
+        const bool inserted = actual.insert(id).second;
+        assert(inserted);
+        (void)inserted;
+    });
+    assert(actual == expected);
+}
+
+void testDynamic() {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    std::uniform_int_distribution<std::uint32_t> pickId(0, 4999);
+
+    mapbox::base::DynamicKDBush<double> index(64, 16);
+    std::vector<Point> reference(5000);
+    std::vector<bool> present(5000, false);
+    auto check = [&] { checkDynamic(index, reference, present, rng); };
+
+    for (int step = 0; step < 20000; ++step) {
+        const std::uint32_t id = pickId(rng);
+        if (step % 4 == 3) {
+            const bool removed = index.remove(id);
+            assert(removed == present[id]);
+            (void)removed;
+            present[id] = false;
+        } else {
+            reference[id] = Point(coordinate(rng), coordinate(rng));
+            present[id] = true;
+            index.insert(id, reference[id].first, reference[id].second);
+        }
+        if (step % 500 == 0) {
+            check();
+        }
+    }
+    assert(index.size() == static_cast<std::size_t>(std::count(present.begin(), present.end(), true)));
+    check();
+
+    index.compact();
+    check();
+
+    for (std::uint32_t id = 0; id < reference.size(); ++id) {
+        index.remove(id);
+    }
+    assert(index.size() == 0u);
+    bool visited = false;
+    index.range(0.0, 0.0, 1000.0, 1000.0, [&](std::uint32_t) { visited = true; });
+    assert(!visited);
+}
+
+void testDynamicBackground() {
+    // Large merges run on another thread. Points moved or removed while they run must
+    // neither come back nor go missing once the merged levels are swapped in.
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    std::uniform_int_distribution<std::uint32_t> pickId(0, 39999);
+
+    mapbox::base::DynamicKDBush<double> index(16);
+    std::vector<Point> reference(40000);
+    std::vector<bool> present(40000, false);
+    auto move = [&](std::uint32_t id) {
+        reference[id] = Point(coordinate(rng), coordinate(rng));
+        present[id] = true;
+        index.insert(id, reference[id].first, reference[id].second);
+    };
+
+    for (std::uint32_t id = 0; id < reference.size(); ++id) {
+        move(id);
+    }
+    for (int step = 0; step < 60000; ++step) {
+        const std::uint32_t id = pickId(rng);
+        if (step % 3 == 2) {
+            const bool removed = index.remove(id);
+            assert(removed == present[id]);
+            (void)removed;
+            present[id] = false;
+        } else {
+            move(id);
+        }
+        if (step % 1999 == 0) {
+            checkDynamic(index, reference, present, rng);
+        }
+    }
+    assert(index.size() == static_cast<std::size_t>(std::count(present.begin(), present.end(), true)));
+
+    // Removing most points leaves levels to be rebuilt by the following inserts.
+    for (std::uint32_t id = 0; id < 36000; ++id) {
+        index.remove(id);
+        present[id] = false;
+    }
+    for (std::uint32_t id = 0; id < 4000; ++id) {
+        move(id);
+    }
+    assert(index.size() == static_cast<std::size_t>(std::count(present.begin(), present.end(), true)));
+    checkDynamic(index, reference, present, rng);
+    index.compact();
+    checkDynamic(index, reference, present, rng);
+}
+
+void testDynamicBatch() {
+    mapbox::base::DynamicKDBush<double> index(4);
+    for (std::uint32_t id = 0; id < 10; ++id) {
+        index.insert(id, id, id);
+    }
+    const std::vector<mapbox::base::BatchQuery<double>::Box> boxes{{0.0, 0.0, 2.0, 2.0}, {8.5, 8.5, 20.0, 20.0}};
+    std::vector<Match> actual;
+    mapbox::base::BatchQuery<double> batch;
+    batch.range(index, boxes.data(), boxes.size(), [&](std::size_t query, std::uint32_t id) {
+        actual.emplace_back(query, id);
+    });
+    std::sort(actual.begin(), actual.end());
+    assert((actual == std::vector<Match>{{0, 0}, {0, 1}, {0, 2}, {1, 9}}));
+}
+
+struct Box {
+    struct {
+        double x;
+        double y;
+    } min, max;
+};
+
+std::vector<Box> randomBoxes(std::size_t count, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    std::uniform_real_distribution<double> extent(0.0, 10.0);
+    std::vector<Box> boxes;
+    for (std::size_t i = 0; i < count; ++i) {
+        const double x = coordinate(rng);
+        const double y = coordinate(rng);
+        boxes.push_back({{x, y}, {x + extent(rng), y + extent(rng)}});
+    }
+    return boxes;
+}
+
+mapbox::base::Flatbush<double> buildFlatbush(const std::vector<Box>& boxes, std::uint16_t nodeSize, unsigned threads) {
+    mapbox::base::Flatbush<double> index(boxes.size(), nodeSize);
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        const std::uint32_t position = index.add(boxes[i]);
+        assert(position == i);
+        (void)position;
+    }
+    index.finish(threads);
+    return index;
+}
+
+void checkFlatbushRange(const mapbox::base::Flatbush<double>& index, const std::vector<Box>& boxes, std::mt19937& rng) {
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    std::vector<std::uint32_t> stack;
+    for (int i = 0; i < 50; ++i) {
+        const double minX = coordinate(rng);
+        const double minY = coordinate(rng);
+        const double maxX = minX + 50.0;
+        const double maxY = minY + 20.0;
+
+        std::vector<std::uint32_t> expected;
+        for (std::uint32_t j = 0; j < boxes.size(); ++j) {
+            const Box& b = boxes[j];
+            if (b.min.x <= maxX && b.min.y <= maxY && b.max.x >= minX && b.max.y >= minY) {
+                expected.push_back(j);
+            }
+        }
+        std::vector<std::uint32_t> actual;
+        index.range(minX, minY, maxX, maxY, [&](std::uint32_t j) { actual.push_back(j); }, stack);
+        std::sort(actual.begin(), actual.end());
+        assert(actual == expected);
+    }
+}
+
+void testFlatbush() {
+    std::mt19937 rng(4);
+    for (const std::size_t count : {1u, 5u, 16u, 17u, 1000u, 10000u}) {
+        const auto boxes = randomBoxes(count, rng);
+        const auto index = buildFlatbush(boxes, 16, 1);
+        assert(index.size() == count);
+        checkFlatbushRange(index, boxes, rng);
+    }
+
+    const auto boxes = randomBoxes(5000, rng);
+    const auto index = buildFlatbush(boxes, 4, 1);
+    checkFlatbushRange(index, boxes, rng);
+
+    std::vector<std::uint32_t> all;
+    index.range(-1.0, -1.0, 2000.0, 2000.0, [&](std::uint32_t j) { all.push_back(j); });
+    assert(all.size() == boxes.size());
+}
+
+void testFlatbushNeighbors() {
+    std::mt19937 rng(5);
+    const auto boxes = randomBoxes(5000, rng);
+    const auto index = buildFlatbush(boxes, 16, 1);
+
+    auto distance = [](const Box& b, double x, double y) {
+        const double dx = x < b.min.x ? b.min.x - x : x <= b.max.x ? 0.0 : x - b.max.x;
+        const double dy = y < b.min.y ? b.min.y - y : y <= b.max.y ? 0.0 : y - b.max.y;
+        return std::sqrt(dx * dx + dy * dy);
+    };
+
+    std::uniform_real_distribution<double> coordinate(0.0, 1000.0);
+    for (int i = 0; i < 50; ++i) {
+        const double x = coordinate(rng);
+        const double y = coordinate(rng);
+
+        const auto nearest = index.neighbors(x, y, 10);
+        assert(nearest.size() == 10u);
+        std::vector<double> expected;
+        for (const auto& b : boxes) {
+            expected.push_back(distance(b, x, y));
+        }
+        std::sort(expected.begin(), expected.end());
+        for (std::size_t j = 0; j < nearest.size(); ++j) {
+            assert(distance(boxes[nearest[j]], x, y) == expected[j]);
+        }
+
+        const auto close = index.neighbors(x, y, boxes.size(), 15.0);
+        const auto inRange = std::upper_bound(expected.begin(), expected.end(), 15.0) - expected.begin();
+        assert(close.size() == static_cast<std::size_t>(inRange));
+    }
+
+    assert(index.neighbors(0.0, 0.0, 0).empty());
+}
+
+void testFlatbushParallel() {
+    std::mt19937 rng(6);
+    const auto boxes = randomBoxes(300000, rng);
+    const auto serial = buildFlatbush(boxes, 16, 1);
+    const auto parallel = buildFlatbush(boxes, 16, 4);
+    assert(serial.byteSize() == parallel.byteSize());
+    assert(std::memcmp(serial.data(), parallel.data(), serial.byteSize()) == 0);
+    checkFlatbushRange(parallel, boxes, rng);
+}
+
+void testFlatbushEmpty() {
+    mapbox::base::Flatbush<double> index(0);
+    index.finish(4);
+    assert(index.size() == 0u);
+
+    bool visited = false;
+    index.range(-1e9, -1e9, 1e9, 1e9, [&](std::uint32_t) { visited = true; });
+    assert(!visited);
+    assert(index.neighbors(0.0, 0.0, 10).empty());
+
+    std::vector<double> buffer(index.byteSize() / sizeof(double) + 1);
+    auto* data = reinterpret_cast<std::uint8_t*>(buffer.data());
+    std::memcpy(data, index.data(), index.byteSize());
+    auto view = mapbox::base::Flatbush<double>::view(data, index.byteSize());
+    assert(view);
+    assert(view->size() == 0u);
+    assert(view->neighbors(0.0, 0.0, 10).empty());
+
+    // Node sizes below 2 are raised to 2.
+    std::mt19937 rng(8);
+    const auto boxes = randomBoxes(100, rng);
+    const auto small = buildFlatbush(boxes, 1, 1);
+    std::vector<std::uint32_t> all;
+    small.range(-1.0, -1.0, 2000.0, 2000.0, [&](std::uint32_t j) { all.push_back(j); });
+    assert(all.size() == boxes.size());
+}
+
+void testFlatbushView() {
+    std::mt19937 rng(7);
+    const auto boxes = randomBoxes(2000, rng);
+    const auto index = buildFlatbush(boxes, 8, 1);
+
+    // Copy into a double-aligned buffer, as a memory-mapped file would be.
+    std::vector<double> buffer(index.byteSize() / sizeof(double) + 1);
+    auto* data = reinterpret_cast<std::uint8_t*>(buffer.data());
+    std::memcpy(data, index.data(), index.byteSize());
+
+    auto view = mapbox::base::Flatbush<double>::view(data, index.byteSize());
+    assert(view);
+    assert(view->size() == boxes.size());
+    assert(view->data() == data);
+    checkFlatbushRange(*view, boxes, rng);
+    assert(view->neighbors(500.0, 500.0, 5) == index.neighbors(500.0, 500.0, 5));
+
+    const bool truncated = bool(mapbox::base::Flatbush<double>::view(data, index.byteSize() - 1));
+    const bool otherType = bool(mapbox::base::Flatbush<float>::view(data, index.byteSize()));
+    const bool unaligned = bool(mapbox::base::Flatbush<double>::view(data + 1, index.byteSize() - 1));
+    assert(!truncated && !otherType && !unaligned);
+    (void)truncated;
+    (void)otherType;
+    (void)unaligned;
+
+    // Node and item indices that would send queries outside the buffer are rejected. The
+    // indices follow the boxes, one per node, with the root last.
+    const std::size_t numNodes = (index.byteSize() - 8) / (4 * sizeof(double) + sizeof(std::uint32_t));
+    auto* indices = data + index.byteSize() - numNodes * sizeof(std::uint32_t);
+    auto corrupt = [&](std::size_t node, std::uint32_t value) {
+        std::uint32_t original;
+        std::memcpy(&original, indices + node * sizeof(value), sizeof(value));
+        std::memcpy(indices + node * sizeof(value), &value, sizeof(value));
+        const auto result = mapbox::base::Flatbush<double>::view(data, index.byteSize());
+        std::memcpy(indices + node * sizeof(value), &original, sizeof(value));
+        return result ? std::string() : result.error();
+    };
+    const std::string root = corrupt(numNodes - 1, 0xffffffffu);
+    const std::string parent = corrupt(boxes.size(), 4u);
+    const std::string item = corrupt(0, static_cast<std::uint32_t>(boxes.size()));
+    assert(root == "Flatbush data is corrupt");
+    assert(parent == "Flatbush data is corrupt");
+    assert(item == "Flatbush data is corrupt");
+    (void)root;
+    (void)parent;
+    (void)item;
+
+    // A header promising more items than a tree can index is rejected before sizing it.
+    std::uint32_t numItems = 0xffffffffu;
+    std::memcpy(data + 4, &numItems, sizeof(numItems));
+    const auto tooMany = mapbox::base::Flatbush<double>::view(data, index.byteSize());
+    assert(!tooMany && tooMany.error() == "Flatbush data size mismatch");
+    numItems = static_cast<std::uint32_t>(boxes.size());
+    std::memcpy(data + 4, &numItems, sizeof(numItems));
+
+    data[0] = 0;
+    const auto notIndex = mapbox::base::Flatbush<double>::view(data, index.byteSize());
+    assert(!notIndex && notIndex.error() == "Data is not a Flatbush index");
+}
+
+} // namespace
+
+int main() {
+    testBatchRange();
+    testBatchWithin();
+    testBatchEmpty();
+    testDynamic();
+    testDynamicBackground();
+    testDynamicBatch();
+    testFlatbush();
+    testFlatbushNeighbors();
+    testFlatbushParallel();
+    testFlatbushEmpty();
+    testFlatbushView();
+    return 0;
+}